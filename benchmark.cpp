@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark.hpp"
+
+#include <cstdio>
+#include <iomanip>
+#include <string>
+
+using namespace std;
+
+namespace benchmark {
+
+double Result::total_time() const {
+    return m_generate_time + m_sort_time + m_vertices_time + m_write_time;
+}
+
+// Whether the two results have the same amount of vertices and edges per thread
+static bool same_work_per_thread(const Result& a, const Result& b){
+    return a.m_num_vertices * b.m_num_threads == b.m_num_vertices * a.m_num_threads &&
+           a.m_num_edges * b.m_num_threads == b.m_num_edges * a.m_num_threads;
+}
+
+void compute_scaling(vector<Result>& results){
+    for(auto& result : results){
+        if(result.total_time() <= 0) continue;
+
+        // the baselines, i.e. the runs with the fewest threads, and whether each series has more than one run
+        const Result* strong_base = nullptr;
+        const Result* weak_base = nullptr;
+        bool strong_series = false;
+        bool weak_series = false;
+        for(auto& candidate : results){
+            if(candidate.total_time() <= 0) continue;
+            if(candidate.m_num_vertices == result.m_num_vertices && candidate.m_num_edges == result.m_num_edges){
+                if(strong_base == nullptr || candidate.m_num_threads < strong_base->m_num_threads){ strong_base = &candidate; }
+                strong_series |= (candidate.m_num_threads != result.m_num_threads);
+            }
+            if(same_work_per_thread(candidate, result)){
+                if(weak_base == nullptr || candidate.m_num_threads < weak_base->m_num_threads){ weak_base = &candidate; }
+                weak_series |= (candidate.m_num_threads != result.m_num_threads);
+            }
+        }
+
+        if(strong_series){
+            result.m_strong_efficiency = (strong_base->total_time() * strong_base->m_num_threads) / (result.total_time() * result.m_num_threads);
+        }
+        if(weak_series){
+            result.m_weak_efficiency = weak_base->total_time() / result.total_time();
+        }
+    }
+}
+
+void print(ostream& out, const vector<Result>& results){
+    auto fmt_double = [](const char* format, double value){
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), format, value);
+        return string(buffer);
+    };
+    auto fmt_efficiency = [&](double value){
+        return value < 0 ? string("-") : fmt_double("%.1f%%", value * 100);
+    };
+
+    auto print_row = [&](const string& vertices, const string& edges, const string& threads, const string& generate, const string& sort,
+            const string& vertices_time, const string& write, const string& total, const string& rate, const string& strong, const string& weak){
+        out << setw(12) << vertices << "  " << setw(12) << edges << "  " << setw(7) << threads << "  " << setw(10) << generate
+            << "  " << setw(10) << sort << "  " << setw(10) << vertices_time << "  " << setw(10) << write << "  " << setw(10) << total
+            << "  " << setw(12) << rate << "  " << setw(8) << strong << "  " << setw(8) << weak << "\n";
+    };
+
+    print_row("Vertices", "Edges", "Threads", "Generate", "Sort", "Vertices", "Write", "Total", "M edges/s", "Strong", "Weak");
+    for(auto& r : results){
+        print_row(to_string(r.m_num_vertices), to_string(r.m_num_edges), to_string(r.m_num_threads),
+                fmt_double("%.3f s", r.m_generate_time), fmt_double("%.3f s", r.m_sort_time), fmt_double("%.3f s", r.m_vertices_time),
+                fmt_double("%.3f s", r.m_write_time), fmt_double("%.3f s", r.total_time()),
+                r.total_time() > 0 ? fmt_double("%.2f", r.m_num_edges / r.total_time() / 1e6) : string("-"),
+                fmt_efficiency(r.m_strong_efficiency), fmt_efficiency(r.m_weak_efficiency));
+    }
+    out.flush();
+}
+
+vector<string> split(const string& list){
+    vector<string> result;
+    size_t start = 0;
+    while(start <= list.size()){
+        size_t end = list.find(',', start);
+        if(end == string::npos) end = list.size();
+        if(end > start){ result.push_back(list.substr(start, end - start)); }
+        start = end +1;
+    }
+    return result;
+}
+
+} // namespace benchmark
@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * End-to-end benchmark of the generator: the whole pipeline (generate, sort, create and save the vertices and
+ * the edges) is executed for each combination of vertices, edges and threads, and the best run of each
+ * combination is compared against the others to compute the strong and the weak scaling efficiency.
+ */
+namespace benchmark {
+
+struct Result {
+    uint64_t m_num_vertices = 0; // number of vertices in the graph
+    uint64_t m_num_edges = 0; // number of edges in the graph
+    int m_num_threads = 0; // number of threads used in the run
+    double m_generate_time = 0; // time to generate the edges, in seconds
+    double m_sort_time = 0; // time to sort the edges, in seconds
+    double m_vertices_time = 0; // time to create the vertices, in seconds
+    double m_write_time = 0; // time to save the vertices and the edges, in seconds
+    uint64_t m_bytes_written = 0; // bytes written to the output files
+    double m_strong_efficiency = -1; // see #compute_scaling, negative if not available
+    double m_weak_efficiency = -1; // see #compute_scaling, negative if not available
+
+    // The time of the whole pipeline, in seconds
+    double total_time() const;
+};
+
+/**
+ * Compute the scaling efficiency of each result.
+ * - Strong scaling: same graph, more threads. The baseline is the run of the same graph with the fewest threads,
+ *   the efficiency is (T_base * threads_base) / (T * threads).
+ * - Weak scaling: same amount of vertices and edges per thread. The baseline is the run with the fewest threads
+ *   among those with the same V / threads and E / threads, the efficiency is T_base / T.
+ * The efficiencies are left negative for the runs that are not part of a series with at least two thread counts.
+ */
+void compute_scaling(std::vector<Result>& results);
+
+// Print the results as a table
+void print(std::ostream& out, const std::vector<Result>& results);
+
+// Split a comma separated list of values, as given to the benchmarks, e.g. -V 1M,2M,4M. Empty items are skipped.
+std::vector<std::string> split(const std::string& list);
+
+} // namespace benchmark
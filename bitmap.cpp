@@ -0,0 +1,158 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "bitmap.hpp"
+
+#include <cassert>
+#include <limits>
+
+#include "lib/common/error.hpp"
+#include "generator.hpp"
+#include "memory.hpp"
+#include "numa.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+AdjacencyBitmap::AdjacencyBitmap(uint64_t num_vertices, bool directed) : m_num_vertices(num_vertices), m_directed(directed), m_num_words(memory_footprint(num_vertices, directed) / sizeof(uint64_t)), m_words(nullptr) {
+    if(num_vertices > (1ull<<32)){ ERROR("Too many vertices for an adjacency bitmap: " << num_vertices); }
+    // the OS hands out zeroed pages lazily, rather than touching the whole bitmap upfront. Any thread can set a bit
+    // anywhere in the bitmap: spread the pages among the nodes
+    m_words = (uint64_t*) memory::allocate_large(max<uint64_t>(m_num_words, 1) * sizeof(uint64_t));
+    numa::interleave_memory(m_words, max<uint64_t>(m_num_words, 1) * sizeof(uint64_t));
+}
+
+AdjacencyBitmap::~AdjacencyBitmap(){
+    memory::deallocate_large(m_words); m_words = nullptr;
+}
+
+uint64_t AdjacencyBitmap::memory_footprint(uint64_t n, bool directed) noexcept {
+    if(n > (1ull<<32)) return numeric_limits<uint64_t>::max();
+    uint64_t num_bits = count_edges_before(n, n, directed);
+    return (num_bits + 63) / 64 * sizeof(uint64_t);
+}
+
+uint64_t AdjacencyBitmap::row_offset(uint64_t source) const noexcept {
+    return count_edges_before(source, m_num_vertices, m_directed);
+}
+
+uint64_t AdjacencyBitmap::bit_index(const Edge& edge) const noexcept {
+    assert((m_directed || edge.m_source < edge.m_destination) && edge.m_source != edge.m_destination && edge.m_destination < m_num_vertices);
+    return row_offset(edge.m_source) + edge_position(edge, m_directed);
+}
+
+uint64_t AdjacencyBitmap::find_row(uint64_t bit) const noexcept {
+    // binary search for the last row whose offset is <= bit
+    uint64_t low = 0, high = m_directed ? m_num_vertices : m_num_vertices -1; // in an undirected graph, the last row is always empty
+    while(high - low > 1){
+        uint64_t mid = low + (high - low) / 2;
+        if(row_offset(mid) <= bit){
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool AdjacencyBitmap::test_and_set(const Edge& edge) noexcept {
+    uint64_t bit = bit_index(edge);
+    uint64_t mask = 1ull << (bit % 64);
+    uint64_t& word = m_words[bit / 64];
+    bool is_new = (word & mask) == 0;
+    word |= mask;
+    return is_new;
+}
+
+bool AdjacencyBitmap::atomic_test_and_set(const Edge& edge) noexcept {
+    uint64_t bit = bit_index(edge);
+    uint64_t mask = 1ull << (bit % 64);
+    uint64_t previous = __atomic_fetch_or(m_words + bit / 64, mask, __ATOMIC_RELAXED);
+    return (previous & mask) == 0;
+}
+
+edge_list_t AdjacencyBitmap::to_edges(int num_threads) const {
+    num_threads = max<int>(1, min<uint64_t>(num_threads, m_num_words));
+    auto get_range = [this, num_threads](int thread_id, uint64_t* out_start, uint64_t* out_end){
+        *out_start = m_num_words * thread_id / num_threads;
+        *out_end = m_num_words * (thread_id +1) / num_threads;
+    };
+
+    // first pass, count the number of edges in each range of words
+    vector<uint64_t> offsets(num_threads +1, 0);
+    auto count_edges = [&](int thread_id){
+        uint64_t start, end;
+        get_range(thread_id, &start, &end);
+        trace::Span span { "bitmap.count", start };
+        uint64_t count = 0;
+        for(uint64_t i = start; i < end; i++){ count += __builtin_popcountll(m_words[i]); }
+        offsets[thread_id +1] = count;
+    };
+
+    // second pass, decode the position of each bit set into its edge
+    edge_list_t edges;
+    auto decode_edges = [&](int thread_id){
+        uint64_t start, end;
+        get_range(thread_id, &start, &end);
+        if(start == end) return;
+        trace::Span span { "bitmap.decode", start };
+
+        uint64_t position = offsets[thread_id];
+        uint64_t row = find_row(start * 64);
+        uint64_t row_start = row_offset(row);
+        uint64_t row_end = row_offset(row +1);
+        for(uint64_t i = start; i < end; i++){
+            uint64_t word = m_words[i];
+            while(word != 0){
+                uint64_t bit = i * 64 + __builtin_ctzll(word);
+                word &= word -1; // reset the lowest bit
+                while(bit >= row_end){
+                    row++;
+                    row_start = row_end;
+                    row_end = row_offset(row +1);
+                }
+                edges[position++] = edge_at_position(row, bit - row_start, m_directed);
+            }
+        }
+        assert(position == offsets[thread_id +1]);
+    };
+
+    run_in_parallel(num_threads, count_edges);
+    for(int i = 1; i <= num_threads; i++){ offsets[i] += offsets[i -1]; }
+    edges.resize(offsets[num_threads]);
+    run_in_parallel(num_threads, decode_edges);
+
+    return edges;
+}
+
+edge_list_t make_edges_bitmap(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, bool directed){
+    AdjacencyBitmap bitmap { num_vertices, directed };
+
+    if(num_threads <= 1){
+        generate_edges(num_vertices, num_edges, seed, 1, [&bitmap](int, const Edge& edge){
+            return bitmap.test_and_set(edge);
+        }, directed);
+    } else {
+        generate_edges(num_vertices, num_edges, seed, num_threads, [&bitmap](int, const Edge& edge){
+            return bitmap.atomic_test_and_set(edge); // only one thread can flip a given bit
+        }, directed);
+    }
+
+    edge_list_t edges = bitmap.to_edges(num_threads);
+    assert(edges.size() == num_edges && "The number of edges created does not match what the user requested");
+    return edges;
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "edge.hpp"
+
+/**
+ * The upper triangle of the adjacency matrix of an undirected graph, stored as a bitmap.
+ * The bits are laid out row by row: the row for the source u contains the bits for the
+ * destinations u+1, ..., num_vertices -1, so that an undirected graph with n vertices
+ * takes n * (n -1) / 2 bits overall. For a directed graph, the whole matrix but the diagonal
+ * is stored, the row for u contains the bits for all destinations v != u, n * (n -1) bits.
+ */
+class AdjacencyBitmap {
+    const uint64_t m_num_vertices; // number of rows & columns in the matrix
+    const bool m_directed; // whether the edges (u, v) and (v, u) are distinct
+    const uint64_t m_num_words; // number of 64-bit words in the bitmap
+    uint64_t* m_words; // the content of the bitmap
+
+    // Position of the first bit in the given row
+    uint64_t row_offset(uint64_t source) const noexcept;
+
+    // Position of the bit associated to the given edge
+    uint64_t bit_index(const Edge& edge) const noexcept;
+
+    // Retrieve the row containing the given bit
+    uint64_t find_row(uint64_t bit) const noexcept;
+
+public:
+    // Create an empty bitmap
+    AdjacencyBitmap(uint64_t num_vertices, bool directed = false);
+
+    // Destructor
+    ~AdjacencyBitmap();
+
+    AdjacencyBitmap(const AdjacencyBitmap&) = delete;
+    AdjacencyBitmap& operator=(const AdjacencyBitmap&) = delete;
+
+    // Set the bit for the given edge. Return true if the bit was not already set, false otherwise
+    bool test_and_set(const Edge& edge) noexcept;
+
+    // Same as #test_and_set, but safe to invoke concurrently from multiple threads
+    bool atomic_test_and_set(const Edge& edge) noexcept;
+
+    // Retrieve the list of edges recorded in the bitmap, sorted by source and destination
+    edge_list_t to_edges(int num_threads) const;
+
+    // The amount of memory, in bytes, required by a bitmap for the given number of vertices
+    static uint64_t memory_footprint(uint64_t num_vertices, bool directed = false) noexcept;
+};
+
+/**
+ * Generate a random graph with the given number of edges, using an adjacency bitmap to discard the duplicates.
+ * The list of edges returned is already sorted.
+ */
+edge_list_t make_edges_bitmap(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, bool directed = false);
@@ -0,0 +1,135 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "components.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "generator.hpp"
+#include "memory.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+ConnectedComponents::ConnectedComponents(uint64_t num_vertices, int num_threads) : m_num_vertices(num_vertices),
+        m_num_threads(max<int64_t>(1, min<int64_t>(num_threads, num_vertices / (1ull << 16)))),
+        m_parents((uint64_t*) memory::allocate_large(max<uint64_t>(num_vertices, 1) * sizeof(uint64_t))),
+        m_degrees((uint64_t*) memory::allocate_large(max<uint64_t>(num_vertices, 1) * sizeof(uint64_t))) {
+    run_in_parallel(m_num_threads, [&](int thread_id){
+        for(uint64_t v = num_vertices * thread_id / m_num_threads, end = num_vertices * (thread_id +1) / m_num_threads; v < end; v++){
+            m_parents[v] = v;
+            m_degrees[v] = 0;
+        }
+    });
+}
+
+ConnectedComponents::~ConnectedComponents(){
+    memory::deallocate_large(m_parents);
+    memory::deallocate_large(m_degrees);
+}
+
+uint64_t ConnectedComponents::find(uint64_t vertex) noexcept {
+    while(true){
+        uint64_t parent = __atomic_load_n(m_parents + vertex, __ATOMIC_RELAXED);
+        if(parent == vertex) return vertex;
+        uint64_t grandparent = __atomic_load_n(m_parents + parent, __ATOMIC_RELAXED);
+        if(parent != grandparent){ // the parent of a vertex can only decrease, a failed CAS is harmless
+            __atomic_compare_exchange_n(m_parents + vertex, &parent, grandparent, /* weak */ true, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+        vertex = grandparent;
+    }
+}
+
+void ConnectedComponents::unite(uint64_t u, uint64_t v) noexcept {
+    while(true){
+        u = find(u);
+        v = find(v);
+        if(u == v) return;
+        if(u < v) swap(u, v);
+        uint64_t expected = u;
+        if(__atomic_compare_exchange_n(m_parents + u, &expected, v, /* weak */ false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return;
+    }
+}
+
+void ConnectedComponents::add_edges(const edge_list_t& edges){
+    const int num_threads = max<int64_t>(1, min<int64_t>(m_num_threads, edges.size() / (1ull << 16)));
+    run_in_parallel(num_threads, [&](int thread_id){
+        const uint64_t start = edges.size() * thread_id / num_threads, end = edges.size() * (thread_id +1) / num_threads;
+        trace::Span span { "components.union", start };
+        for(uint64_t i = start; i < end; i++){
+            const Edge& edge = edges[i];
+            unite(edge.m_source, edge.m_destination);
+            __atomic_fetch_add(m_degrees + edge.m_source, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(m_degrees + edge.m_destination, 1, __ATOMIC_RELAXED);
+        }
+    });
+}
+
+LargestComponent ConnectedComponents::largest_component(){
+    const uint64_t num_vertices = m_num_vertices;
+    const int num_threads = m_num_threads;
+
+    // the size of each component, counted at its root
+    uint64_t* sizes = (uint64_t*) memory::allocate_large(max<uint64_t>(num_vertices, 1) * sizeof(uint64_t));
+    run_in_parallel(num_threads, [&](int thread_id){
+        for(uint64_t v = num_vertices * thread_id / num_threads, end = num_vertices * (thread_id +1) / num_threads; v < end; v++){ sizes[v] = 0; }
+    });
+    vector<uint64_t> num_roots(num_threads, 0);
+    run_in_parallel(num_threads, [&](int thread_id){
+        const uint64_t start = num_vertices * thread_id / num_threads, end = num_vertices * (thread_id +1) / num_threads;
+        trace::Span span { "components.count", start };
+        for(uint64_t v = start; v < end; v++){
+            uint64_t root = find(v);
+            num_roots[thread_id] += (root == v);
+            __atomic_fetch_add(sizes + root, 1, __ATOMIC_RELAXED);
+        }
+    });
+
+    LargestComponent result;
+    uint64_t largest = 0; // the root of the largest component, the smallest one in case of ties
+    for(uint64_t v = 0; v < num_vertices; v++){
+        if(sizes[v] > sizes[largest]){ largest = v; }
+    }
+    for(auto count : num_roots){ result.m_num_components += count; }
+    result.m_num_vertices = (num_vertices > 0) ? sizes[largest] : 0;
+    memory::deallocate_large(sizes); sizes = nullptr;
+
+    // the vertex with the highest degree in the largest component, the smallest one in case of ties
+    vector<uint64_t> best(num_threads, largest); // for each thread
+    run_in_parallel(num_threads, [&](int thread_id){
+        const uint64_t start = num_vertices * thread_id / num_threads, end = num_vertices * (thread_id +1) / num_threads;
+        trace::Span span { "components.degree", start };
+        uint64_t vertex = largest;
+        for(uint64_t v = start; v < end; v++){
+            if(m_degrees[v] > m_degrees[vertex] && find(v) == largest){ vertex = v; }
+        }
+        best[thread_id] = vertex;
+    });
+    result.m_vertex = largest;
+    for(uint64_t v : best){
+        if(m_degrees[v] > m_degrees[result.m_vertex] || (m_degrees[v] == m_degrees[result.m_vertex] && v < result.m_vertex)){ result.m_vertex = v; }
+    }
+
+    return result;
+}
+
+LargestComponent find_largest_component(const edge_list_t& edges, uint64_t num_vertices, int num_threads){
+    ConnectedComponents components { num_vertices, num_threads };
+    components.add_edges(edges);
+    return components.largest_component();
+}
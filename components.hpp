@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "edge.hpp"
+
+/**
+ * The largest connected component of a graph, ignoring the direction of the edges, i.e. the largest weakly
+ * connected component of a directed graph.
+ */
+struct LargestComponent {
+    uint64_t m_num_components = 0; // number of connected components, including the isolated vertices
+    uint64_t m_num_vertices = 0; // number of vertices in the largest component
+    uint64_t m_vertex = 0; // the vertex of the largest component with the highest degree (in + out edges), as a position
+};
+
+/**
+ * The connected components of a graph, computed with a concurrent union-find: the threads link the roots of the
+ * endpoints of a slice of the edges each, with a CAS from the larger to the smaller root. The edges can be added
+ * in more rounds, e.g. one for each part of the graph, so that the whole list never needs to be in memory.
+ */
+class ConnectedComponents {
+    const uint64_t m_num_vertices; // number of vertices in the graph
+    const int m_num_threads; // number of threads to use
+    uint64_t* m_parents; // the parent of each vertex, itself for a root, each root is the smallest vertex of its set
+    uint64_t* m_degrees; // number of edges incident to each vertex
+
+    // The root of the given vertex, halving the path on the way
+    uint64_t find(uint64_t vertex) noexcept;
+
+    // Merge the sets of the two vertices
+    void unite(uint64_t u, uint64_t v) noexcept;
+
+public:
+    ConnectedComponents(uint64_t num_vertices, int num_threads);
+
+    ~ConnectedComponents();
+
+    ConnectedComponents(const ConnectedComponents&) = delete;
+    ConnectedComponents& operator=(const ConnectedComponents&) = delete;
+
+    // Merge the endpoints of the given edges, in any order
+    void add_edges(const edge_list_t& edges);
+
+    // Find the largest component among the edges added so far, the one with the smallest vertex in case of ties
+    LargestComponent largest_component();
+};
+
+// Find the largest connected component of the graph with the given edges
+LargestComponent find_largest_component(const edge_list_t& edges, uint64_t num_vertices, int num_threads);
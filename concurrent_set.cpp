@@ -0,0 +1,141 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "concurrent_set.hpp"
+
+#include <cassert>
+
+#include "lib/common/error.hpp"
+#include "generator.hpp"
+#include "memory.hpp"
+#include "numa.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+// Keep the load factor of the table at or below 1/2
+static uint64_t compute_capacity(uint64_t num_edges){
+    uint64_t capacity = 64;
+    while(capacity < 2 * num_edges){ capacity *= 2; }
+    return capacity;
+}
+
+ConcurrentEdgeSet::ConcurrentEdgeSet(uint64_t num_edges) : m_capacity(compute_capacity(num_edges)), m_slots(nullptr) {
+    // the OS hands out zeroed pages lazily. The slots are hashed, any thread probes any page: spread them among the nodes
+    m_slots = (uint64_t*) memory::allocate_large(m_capacity * sizeof(uint64_t));
+    numa::interleave_memory(m_slots, m_capacity * sizeof(uint64_t));
+}
+
+ConcurrentEdgeSet::~ConcurrentEdgeSet(){
+    memory::deallocate_large(m_slots); m_slots = nullptr;
+}
+
+uint64_t ConcurrentEdgeSet::memory_footprint(uint64_t num_edges) noexcept {
+    return compute_capacity(num_edges) * sizeof(uint64_t);
+}
+
+bool ConcurrentEdgeSet::insert(const Edge& edge) noexcept {
+    assert(edge.m_source != edge.m_destination && edge.m_source < MAX_NUM_VERTICES && edge.m_destination < MAX_NUM_VERTICES);
+    const uint64_t key = pack_edge(edge); // never 0, as source != destination
+    const uint64_t mask = m_capacity -1;
+    uint64_t slot = hash_mix(key) & mask;
+
+    while(true){
+        uint64_t current = __atomic_load_n(m_slots + slot, __ATOMIC_RELAXED);
+        if(current == key) return false; // duplicate
+        if(current == 0){
+            if(__atomic_compare_exchange_n(m_slots + slot, &current, key, /* weak */ false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+                return true;
+            } else if(current == key){ // another thread inserted the same edge in the meanwhile
+                return false;
+            } // else, the slot has been taken by another edge, keep probing
+        }
+        slot = (slot +1) & mask;
+    }
+}
+
+edge_list_t ConcurrentEdgeSet::to_edges(int num_threads) const {
+    if(num_threads < 1) num_threads = 1;
+    auto get_range = [this, num_threads](int thread_id, uint64_t* out_start, uint64_t* out_end){
+        *out_start = m_capacity * thread_id / num_threads;
+        *out_end = m_capacity * (thread_id +1) / num_threads;
+    };
+
+    // first pass, count the number of edges in each range of slots
+    vector<uint64_t> offsets(num_threads +1, 0);
+    run_in_parallel(num_threads, [&](int thread_id){
+        uint64_t start, end;
+        get_range(thread_id, &start, &end);
+        trace::Span span { "lockfree.count", start };
+        uint64_t count = 0;
+        for(uint64_t i = start; i < end; i++){ count += (m_slots[i] != 0); }
+        offsets[thread_id +1] = count;
+    });
+    for(int i = 1; i <= num_threads; i++){ offsets[i] += offsets[i -1]; }
+
+    // second pass, copy the edges
+    edge_list_t edges(offsets[num_threads]);
+    run_in_parallel(num_threads, [&](int thread_id){
+        uint64_t start, end;
+        get_range(thread_id, &start, &end);
+        trace::Span span { "lockfree.copy", start };
+        uint64_t position = offsets[thread_id];
+        for(uint64_t i = start; i < end; i++){
+            if(m_slots[i] != 0){ edges[position++] = unpack_edge(m_slots[i]); }
+        }
+        assert(position == offsets[thread_id +1]);
+    });
+
+    return edges;
+}
+
+DedupStatistics ConcurrentEdgeSet::statistics(int num_threads) const {
+    if(num_threads < 1) num_threads = 1;
+    vector<DedupStatistics> partial(num_threads);
+    run_in_parallel(num_threads, [&](int thread_id){
+        const uint64_t start = m_capacity * thread_id / num_threads;
+        const uint64_t end = m_capacity * (thread_id +1) / num_threads;
+        const uint64_t mask = m_capacity -1;
+        DedupStatistics stats;
+        for(uint64_t i = start; i < end; i++){
+            if(m_slots[i] == 0) continue;
+            uint64_t probe_length = ((i - (hash_mix(m_slots[i]) & mask)) & mask) +1; // distance from the home slot
+            stats.m_num_probes += probe_length;
+            stats.m_num_keys++;
+            stats.m_max_probe_length = max(stats.m_max_probe_length, probe_length);
+        }
+        partial[thread_id] = stats;
+    });
+
+    DedupStatistics result;
+    for(auto& stats : partial){ result.merge(stats); }
+    return result;
+}
+
+edge_list_t make_edges_lockfree(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, DedupStatistics* out_statistics, bool directed){
+    if(num_vertices > ConcurrentEdgeSet::MAX_NUM_VERTICES){ ERROR("Too many vertices for the lock-free hash set: " << num_vertices); }
+
+    ConcurrentEdgeSet edges_created { num_edges };
+    generate_edges(num_vertices, num_edges, seed, num_threads, [&edges_created](int, const Edge& edge){
+        return edges_created.insert(edge);
+    }, directed);
+
+    edge_list_t edges = edges_created.to_edges(num_threads);
+    assert(edges.size() == num_edges && "The number of edges created does not match what the user requested");
+    if(out_statistics != nullptr){ *out_statistics = edges_created.statistics(num_threads); }
+    return edges;
+}
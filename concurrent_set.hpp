@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "edge.hpp"
+
+/**
+ * A lock-free hash set of edges, based on open addressing with linear probing. Each edge is packed into a
+ * single 64-bit word, source << 32 | destination, and inserted with a CAS on the first empty slot of its
+ * probe sequence. The table cannot be resized, it needs to be sized upfront for the max number of edges
+ * to store, and it only supports graphs with up to 2^32 vertices.
+ */
+class ConcurrentEdgeSet {
+    const uint64_t m_capacity; // number of slots in the table, always a power of 2
+    uint64_t* m_slots; // the content of the table, 0 = empty slot
+
+public:
+    // The max number of vertices in the graph, to be able to pack the edges
+    constexpr static uint64_t MAX_NUM_VERTICES = 1ull << 32;
+
+    // Create an empty set, able to store up to `num_edges' edges
+    ConcurrentEdgeSet(uint64_t num_edges);
+
+    // Destructor
+    ~ConcurrentEdgeSet();
+
+    ConcurrentEdgeSet(const ConcurrentEdgeSet&) = delete;
+    ConcurrentEdgeSet& operator=(const ConcurrentEdgeSet&) = delete;
+
+    // Insert the given edge. Return true if the edge was not already present, false otherwise. Thread safe.
+    bool insert(const Edge& edge) noexcept;
+
+    // Retrieve the list of edges in the set, in no particular order
+    edge_list_t to_edges(int num_threads) const;
+
+    // Compute the probe lengths of the edges in the set. The table is never rehashed.
+    DedupStatistics statistics(int num_threads) const;
+
+    // Number of slots in the table
+    uint64_t capacity() const noexcept { return m_capacity; }
+
+    // The amount of memory, in bytes, required by a set able to store the given number of edges
+    static uint64_t memory_footprint(uint64_t num_edges) noexcept;
+};
+
+/**
+ * Generate a random graph with the given number of edges, using a lock-free hash set, shared by all
+ * threads, to discard the duplicates. The list of edges returned is not sorted.
+ */
+edge_list_t make_edges_lockfree(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, DedupStatistics* out_statistics = nullptr, bool directed = false);
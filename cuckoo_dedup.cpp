@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cuckoo_dedup.hpp"
+
+#include <cassert>
+#include <chrono>
+
+#include "lib/common/error.hpp"
+#include "concurrent_set.hpp"
+#include "generator.hpp"
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t TIMING_SEGMENT = 256; // number of inserts timed together
+
+// Per thread state, padded to avoid false sharing
+struct alignas(64) ThreadState {
+    uint64_t m_position; // next position in the output vector
+    uint64_t m_end; // end of the slice of the thread in the output vector
+    uint64_t m_num_inserts; // inserts in the current segment
+    size_t m_hashpower; // of the table at the start of the current segment
+    chrono::steady_clock::time_point m_segment_start;
+    double m_insert_seconds;
+    double m_expansion_seconds;
+};
+
+} // anonymous namespace
+
+edge_list_t make_edges_cuckoo(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, CuckooStatistics* out_statistics, bool directed){
+    if(num_vertices > ConcurrentEdgeSet::MAX_NUM_VERTICES){ ERROR("Too many vertices for the cuckoo hash map: " << num_vertices); }
+    if(num_threads < 1) num_threads = 1;
+
+    CuckooEdgeSet edges_created;
+    edges_created.max_num_worker_threads(num_threads -1); // if the table still needs to expand, use all threads
+    edges_created.reserve(num_edges + num_edges / 8); // cuckoo hashing needs some slack to reach the requested load factor
+    const size_t initial_hashpower = edges_created.hashpower();
+    const uint64_t capacity_reserved = edges_created.capacity();
+
+    // The thread i accepts exactly num_edges / num_threads edges (+1 for the first num_edges % num_threads threads).
+    // Each thread stores the edges it accepts directly in its own slice of the output, so that there is no need to
+    // extract them later from the map.
+    edge_list_t edges(num_edges);
+    vector<ThreadState> state(num_threads);
+    for(int i = 0; i < num_threads; i++){
+        state[i].m_position = (num_edges / num_threads) * i + min<uint64_t>(i, num_edges % num_threads);
+        state[i].m_end = state[i].m_position + num_edges / num_threads + (static_cast<uint64_t>(i) < num_edges % num_threads);
+        state[i].m_num_inserts = 0;
+        state[i].m_insert_seconds = state[i].m_expansion_seconds = 0;
+    }
+
+    // The inserts are timed in segments of TIMING_SEGMENT calls, rather than one by one, to keep the clock reads off
+    // the hot path. A segment where the table grew is accounted as expansion time: an expansion lasts far longer than
+    // the few inserts around it.
+    generate_edges(num_vertices, num_edges, seed, num_threads, [&](int thread_id, const Edge& edge){
+        ThreadState& ts = state[thread_id];
+        if(ts.m_num_inserts == 0){
+            ts.m_segment_start = chrono::steady_clock::now();
+            ts.m_hashpower = edges_created.hashpower();
+        }
+        bool inserted = edges_created.insert(pack_edge(edge));
+        if(inserted){ edges[ts.m_position++] = edge; }
+        if(++ts.m_num_inserts == TIMING_SEGMENT || ts.m_position == ts.m_end){ // close the segment
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - ts.m_segment_start).count();
+            (edges_created.hashpower() != ts.m_hashpower ? ts.m_expansion_seconds : ts.m_insert_seconds) += seconds;
+            ts.m_num_inserts = 0;
+        }
+        return inserted;
+    }, directed);
+
+    if(out_statistics != nullptr){
+        out_statistics->m_capacity_reserved = capacity_reserved;
+        out_statistics->m_capacity_final = edges_created.capacity();
+        out_statistics->m_num_expansions = edges_created.hashpower() - initial_hashpower;
+        out_statistics->m_insert_seconds = out_statistics->m_expansion_seconds = 0;
+        for(auto& ts : state){
+            out_statistics->m_insert_seconds += ts.m_insert_seconds;
+            out_statistics->m_expansion_seconds += ts.m_expansion_seconds;
+        }
+    }
+
+    assert(edges_created.size() == num_edges && "The number of edges created does not match what the user requested");
+    return edges;
+}
@@ -0,0 +1,51 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "lib/cuckoohash.hpp"
+#include "edge.hpp"
+#include "memory.hpp"
+
+/**
+ * A libcuckoo hash map used as a set of packed edges (see #pack_edge). The payload is empty, so that each
+ * slot takes 16 bytes, rather than 24 bytes for a cuckoohash_map<Edge, bool>.
+ */
+struct CuckooNoPayload { };
+struct CuckooPackedEdgeHash { size_t operator()(uint64_t key) const noexcept { return hash_mix(key); } };
+using CuckooEdgeSet = cuckoohash_map<uint64_t, CuckooNoPayload, CuckooPackedEdgeHash, std::equal_to<uint64_t>, LargeArrayAllocator<std::pair<const uint64_t, CuckooNoPayload>>>;
+
+/**
+ * Time spent by the generator threads in the cuckoo hash map
+ */
+struct CuckooStatistics {
+    uint64_t m_capacity_reserved = 0; // number of slots reserved before starting to insert the edges
+    uint64_t m_capacity_final = 0; // number of slots at the end of the generation
+    uint64_t m_num_expansions = 0; // number of times the table doubled its capacity
+    double m_insert_seconds = 0; // time spent drawing and inserting the candidates outside the expansions, summed over all threads
+    double m_expansion_seconds = 0; // time spent in the segments of inserts where the table expanded, summed over all threads
+};
+
+/**
+ * Generate a random graph with the given number of edges, using a libcuckoo hash map, shared by all threads,
+ * to discard the duplicates. The list of edges returned is not sorted. The time of each thread is measured in
+ * segments of consecutive inserts, those where the table expanded are reported as time in the expansions.
+ */
+edge_list_t make_edges_cuckoo(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, CuckooStatistics* out_statistics = nullptr, bool directed = false);
@@ -0,0 +1,155 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "memory.hpp"
+
+// An undirected edge, always stored with m_source < m_destination, except in the lists of #symmetrize_edges and
+// in directed graphs, see #Edge::directed
+struct Edge {
+    uint64_t m_source;
+    uint64_t m_destination;
+
+    Edge() = default;
+    Edge(uint64_t source, uint64_t destination) : m_source(std::min(source, destination)), m_destination(std::max(source,destination)){ }
+
+    // Create a directed edge, keeping the source and the destination as given
+    static Edge directed(uint64_t source, uint64_t destination) noexcept { Edge e; e.m_source = source; e.m_destination = destination; return e; }
+
+    // Check whether the two edges are equal
+    bool operator==(const Edge& e) const noexcept { return e.m_source == m_source && e.m_destination == m_destination; }
+    bool operator!=(const Edge& e) const noexcept { return !(*this == e); }
+
+    // Order the edges by source and then by destination
+    bool operator<(const Edge& e) const noexcept { return (m_source < e.m_source) || (m_source == e.m_source && m_destination < e.m_destination); }
+};
+
+// Number of the edges (u, v), u < v, whose source u precedes the given source, in a graph with n vertices. If
+// the graph is directed, the edges (u, v), u != v. It requires n <= 2^32 to avoid overflows.
+inline uint64_t count_edges_before(uint64_t source, uint64_t n, bool directed = false) noexcept {
+    if(directed) return source * (n -1);
+    // source * (2n - source -1) / 2, where either of the two factors is even
+    uint64_t factor = 2 * n - source -1;
+    return (source % 2 == 0) ? (source / 2) * factor : source * (factor / 2);
+}
+
+// Position of the edge among those with the same source, in the order of #count_edges_before
+inline uint64_t edge_position(const Edge& edge, bool directed = false) noexcept {
+    if(directed) return edge.m_destination - (edge.m_destination > edge.m_source);
+    return edge.m_destination - edge.m_source -1;
+}
+
+// Retrieve the edge at the given position among those with the given source, the inverse of #edge_position
+inline Edge edge_at_position(uint64_t source, uint64_t position, bool directed = false) noexcept {
+    if(directed) return Edge::directed(source, position + (position >= source));
+    return Edge::directed(source, source + 1 + position);
+}
+
+// A large array of edges, see LargeArrayAllocator
+using edge_list_t = std::vector<Edge, LargeArrayAllocator<Edge>>;
+
+// Split the sources in `num_parts' ranges with about the same number of possible edges. The part i contains
+// the sources [boundaries[i], boundaries[i +1]). It requires num_vertices <= 2^32.
+inline std::vector<uint64_t> split_sources(uint64_t num_vertices, uint64_t num_parts, bool directed = false){
+    const uint64_t max_num_edges = count_edges_before(num_vertices, num_vertices, directed);
+    std::vector<uint64_t> boundaries(num_parts +1);
+    boundaries[0] = 0;
+    boundaries[num_parts] = num_vertices;
+    for(uint64_t i = 1; i < num_parts; i++){
+        uint64_t target = (unsigned __int128) max_num_edges * i / num_parts;
+        // find the first source such that count_edges_before(source) >= target
+        uint64_t low = boundaries[i -1], high = num_vertices -1;
+        while(low < high){
+            uint64_t mid = low + (high - low) / 2;
+            if(count_edges_before(mid, num_vertices, directed) < target){ low = mid +1; } else { high = mid; }
+        }
+        boundaries[i] = low;
+    }
+    return boundaries;
+}
+
+// Split the destinations in `num_parts' ranges with about the same number of possible edges, the destination v
+// being the endpoint of v edges (u, v), u < v. The part i contains the destinations [boundaries[i], boundaries[i +1]).
+inline std::vector<uint64_t> split_destinations(uint64_t num_vertices, uint64_t num_parts){
+    const uint64_t max_num_edges = count_edges_before(num_vertices -1, num_vertices);
+    std::vector<uint64_t> boundaries(num_parts +1);
+    boundaries[0] = 0;
+    boundaries[num_parts] = num_vertices;
+    for(uint64_t i = 1; i < num_parts; i++){
+        uint64_t target = (unsigned __int128) max_num_edges * i / num_parts;
+        // find the first destination such that the destinations before it have >= target edges, d * (d -1) / 2
+        uint64_t low = boundaries[i -1], high = num_vertices -1;
+        while(low < high){
+            uint64_t mid = low + (high - low) / 2;
+            if((unsigned __int128) mid * (mid -1) / 2 < target){ low = mid +1; } else { high = mid; }
+        }
+        boundaries[i] = low;
+    }
+    return boundaries;
+}
+
+// Retrieve the part containing the given source, according to the boundaries computed by #split_sources
+inline uint64_t find_source_part(const std::vector<uint64_t>& boundaries, uint64_t source){
+    return (std::upper_bound(std::begin(boundaries), std::end(boundaries), source) - std::begin(boundaries)) -1;
+}
+
+// Mix the bits of the given key, with the finaliser of splitmix64. Note that hash<uint64_t> is the identity.
+inline uint64_t hash_mix(uint64_t key) noexcept {
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+    return key ^ (key >> 31);
+}
+
+// Pack an edge into a single 64-bit word, source << 32 | destination. Both vertices must be less than 2^32.
+inline uint64_t pack_edge(const Edge& edge) noexcept { return (edge.m_source << 32) | edge.m_destination; }
+
+// Retrieve an edge packed with #pack_edge
+inline Edge unpack_edge(uint64_t key) noexcept { return Edge::directed(key >> 32, key & 0xFFFFFFFFull); }
+
+/**
+ * Statistics of the hash table used to discard the duplicate edges, measured at the end of the generation. The
+ * probe length of an edge is the number of slots inspected to find it in the table.
+ */
+struct DedupStatistics {
+    uint64_t m_num_probes = 0; // sum of the probe lengths of the edges in the table, 0 if not applicable
+    uint64_t m_num_keys = 0; // number of edges accounted in m_num_probes
+    uint64_t m_max_probe_length = 0; // max probe length of an edge in the table
+    uint64_t m_num_rehashes = 0; // number of times the table was resized and its content rehashed
+
+    // Average probe length, or 0 if not applicable
+    double avg_probe_length() const noexcept { return m_num_keys > 0 ? static_cast<double>(m_num_probes) / m_num_keys : 0.0; }
+
+    // Accumulate the statistics of another table
+    void merge(const DedupStatistics& other) noexcept {
+        m_num_probes += other.m_num_probes;
+        m_num_keys += other.m_num_keys;
+        m_max_probe_length = std::max(m_max_probe_length, other.m_max_probe_length);
+        m_num_rehashes += other.m_num_rehashes;
+    }
+};
+
+namespace std {
+template<> struct hash<::Edge>{ // hash function
+    size_t operator()(const Edge& e) const { return hash_mix(e.m_source * 0x9e3779b97f4a7c15ull ^ e.m_destination); }
+};
+} // namespace std
@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "edge.hpp"
+#include "numa.hpp"
+#include "progress.hpp"
+#include "trace.hpp"
+
+/**
+ * Execute fn(thread_id) on `num_threads' threads and wait for all of them to terminate. With NUMA awareness
+ * enabled, each thread is pinned to a CPU of its node. In the trace, the thread i is the worker i.
+ */
+template<typename Function>
+void run_in_parallel(int num_threads, Function&& fn){
+    if(num_threads <= 1){ fn(0); return; }
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for(int thread_id = 0; thread_id < num_threads; thread_id++){
+        threads.emplace_back([&fn, thread_id, num_threads](){
+            numa::pin_thread(thread_id, num_threads);
+            trace::set_thread_id(thread_id +1);
+            fn(thread_id);
+        });
+    }
+    for(auto& t: threads) t.join();
+}
+
+/**
+ * The items in [0, num_items) assigned to the given worker thread, visited as for(i = m_first; i < m_last; i += m_step).
+ * By default the items are dealt round robin, to balance the load. With NUMA awareness enabled, each thread rather
+ * takes a contiguous block, so that the threads of a node read the part of a sorted edge list placed on their node.
+ */
+struct ThreadItems {
+    uint64_t m_first;
+    uint64_t m_last;
+    uint64_t m_step;
+};
+
+inline ThreadItems items_of_thread(uint64_t num_items, int thread_id, int num_threads){
+    if(!numa::is_enabled() || num_threads <= 1){ return ThreadItems{ static_cast<uint64_t>(thread_id), num_items, static_cast<uint64_t>(num_threads) }; }
+    uint64_t first = (unsigned __int128) num_items * thread_id / num_threads;
+    uint64_t last = (unsigned __int128) num_items * (thread_id +1) / num_threads;
+    return ThreadItems{ first, last, 1 };
+}
+
+/**
+ * Draw random candidate edges until `num_edges' distinct edges have been accepted. The work is split among
+ * `num_threads' threads: the thread i uses its own random generator, seeded with seed + i, and accepts
+ * num_edges / num_threads edges. The callback insert(thread_id, edge) must return true if the edge is new
+ * and false if it is a duplicate. If `directed' is true, the candidates are ordered pairs (u, v), u != v, rather
+ * than edges with u < v. In the trace, each span covers GENERATE_EDGES_TRACE_CHUNK edges accepted, and the
+ * progress counters are updated once per chunk.
+ */
+constexpr uint64_t GENERATE_EDGES_TRACE_CHUNK = 1ull << 16;
+
+template<typename Callback>
+void generate_edges(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, Callback&& insert, bool directed = false){
+    if(num_threads < 1) num_threads = 1;
+    run_in_parallel(num_threads, [&](int thread_id){
+        std::mt19937_64 random_generator { seed + thread_id };
+        std::uniform_int_distribution<uint64_t> uniform_distribution {0, num_vertices -1}; // [a, b]
+        const uint64_t num_edges_to_create = num_edges / num_threads + (static_cast<uint64_t>(thread_id) < (num_edges % num_threads));
+        progress::Counters& counters = progress::counters(thread_id);
+
+        uint64_t num_edges_created_insofar = 0;
+        while(num_edges_created_insofar < num_edges_to_create){
+            trace::Span span { "generate", num_edges_created_insofar };
+            const uint64_t chunk_start = num_edges_created_insofar;
+            const uint64_t chunk_end = std::min(num_edges_to_create, num_edges_created_insofar + GENERATE_EDGES_TRACE_CHUNK);
+            uint64_t num_self_loops = 0, num_duplicates = 0;
+            while(num_edges_created_insofar < chunk_end){
+                const uint64_t source = uniform_distribution(random_generator);
+                const uint64_t destination = uniform_distribution(random_generator);
+                const Edge edge = directed ? Edge::directed(source, destination) : Edge{ source, destination };
+                if(edge.m_source == edge.m_destination){ // try again
+                    num_self_loops++;
+                } else if(insert(thread_id, edge)){
+                    num_edges_created_insofar++;
+                } else {
+                    num_duplicates++;
+                }
+            }
+
+            // publish the progress once per chunk
+            progress::Counters::add(counters.m_edges_accepted, num_edges_created_insofar - chunk_start);
+            progress::Counters::add(counters.m_self_loops, num_self_loops);
+            progress::Counters::add(counters.m_duplicates, num_duplicates);
+        }
+    });
+}
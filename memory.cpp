@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "memory.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sys/mman.h>
+#include <unordered_map>
+
+#include "lib/common/error.hpp"
+
+using namespace std;
+
+#if !defined(MAP_HUGE_SHIFT)
+#define MAP_HUGE_SHIFT 26
+#endif
+
+namespace memory {
+
+static HugePages g_huge_pages = HugePages::NONE; // the policy requested
+static mutex g_mutex; // protect the map of the allocations
+static unordered_map<void*, size_t> g_mappings; // the length of each mapping, as needed by munmap
+static bool g_fallback_reported = false; // whether we already warned that the explicit huge pages are not available
+
+void set_huge_pages(HugePages policy){
+    g_huge_pages = policy;
+}
+
+HugePages get_huge_pages(){
+    return g_huge_pages;
+}
+
+// Try to map the area with explicit huge pages of the given size. Return nullptr if the pages are not available.
+static void* map_explicit(size_t* inout_length, int page_shift){
+    const size_t page_size = 1ull << page_shift;
+    size_t length = (*inout_length + page_size -1) & ~(page_size -1);
+    void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_shift << MAP_HUGE_SHIFT), -1, 0);
+    if(ptr == MAP_FAILED) return nullptr;
+    *inout_length = length;
+    return ptr;
+}
+
+void* allocate_large(size_t size){
+    if(size == 0) size = 1;
+    size_t length = size;
+    void* ptr = nullptr;
+
+    HugePages policy = g_huge_pages;
+    if(policy == HugePages::EXPLICIT_2MB || policy == HugePages::EXPLICIT_1GB){
+        ptr = map_explicit(&length, policy == HugePages::EXPLICIT_2MB ? 21 : 30);
+        if(ptr == nullptr){
+            lock_guard<mutex> lock(g_mutex);
+            if(!g_fallback_reported){
+                cerr << "[memory] Cannot map explicit huge pages (" << strerror(errno) << "), check /proc/sys/vm/nr_hugepages. "
+                        "Falling back to transparent huge pages" << endl;
+                g_fallback_reported = true;
+            }
+            policy = HugePages::TRANSPARENT;
+        }
+    }
+
+    if(ptr == nullptr){
+        ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(ptr == MAP_FAILED){ ERROR("Cannot allocate " << size << " bytes: " << strerror(errno)); }
+        if(policy == HugePages::TRANSPARENT){
+            madvise(ptr, length, MADV_HUGEPAGE); // best effort, THP may be disabled in the kernel
+        }
+    }
+
+    lock_guard<mutex> lock(g_mutex);
+    g_mappings[ptr] = length;
+    return ptr;
+}
+
+void deallocate_large(void* ptr){
+    if(ptr == nullptr) return;
+    size_t length = 0;
+    { // restrict the scope
+        lock_guard<mutex> lock(g_mutex);
+        auto it = g_mappings.find(ptr);
+        if(it == g_mappings.end()) return; // not allocated by us
+        length = it->second;
+        g_mappings.erase(it);
+    }
+    munmap(ptr, length);
+}
+
+const char* to_string(HugePages policy){
+    switch(policy){
+    case HugePages::NONE: return "none";
+    case HugePages::TRANSPARENT: return "thp";
+    case HugePages::EXPLICIT_2MB: return "2mb";
+    case HugePages::EXPLICIT_1GB: return "1gb";
+    default: return "unknown";
+    }
+}
+
+HugePages parse_huge_pages(const string& value){
+    if(value == "none"){
+        return HugePages::NONE;
+    } else if(value == "thp"){
+        return HugePages::TRANSPARENT;
+    } else if(value == "2mb"){
+        return HugePages::EXPLICIT_2MB;
+    } else if(value == "1gb"){
+        return HugePages::EXPLICIT_1GB;
+    } else {
+        ERROR("Invalid value for the argument --hugepages: `" << value << "'");
+    }
+}
+
+} // namespace memory
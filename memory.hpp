@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Allocation of the large arrays of the generator: the lists of edges and the dedup tables. These are
+ * accessed at random, so that they are mapped directly with mmap and, if requested, backed by huge pages
+ * to reduce the TLB misses.
+ */
+namespace memory {
+
+enum class HugePages {
+    NONE, // regular pages
+    TRANSPARENT, // regular mappings, advised with madvise(MADV_HUGEPAGE)
+    EXPLICIT_2MB, // MAP_HUGETLB with 2 MB pages, fall back to TRANSPARENT if the pages are not available
+    EXPLICIT_1GB, // MAP_HUGETLB with 1 GB pages, fall back to TRANSPARENT if the pages are not available
+};
+
+// Allocations smaller than this threshold are served by malloc
+constexpr size_t LARGE_ALLOCATION_THRESHOLD = 1ull << 20;
+
+// Set the kind of pages for the large allocations from now on
+void set_huge_pages(HugePages policy);
+
+// The kind of pages requested for the large allocations
+HugePages get_huge_pages();
+
+// Allocate a zeroed memory area of the given size. The pages are only populated when first touched.
+void* allocate_large(size_t size);
+
+// Release a memory area obtained by #allocate_large
+void deallocate_large(void* ptr);
+
+// Textual description of the policy, for the log
+const char* to_string(HugePages policy);
+
+// Parse the policy from its textual description, as given by #to_string
+HugePages parse_huge_pages(const std::string& value);
+
+} // namespace memory
+
+/**
+ * The allocator for the large arrays of the generator, it serves the allocations above the threshold with
+ * #memory::allocate_large. Furthermore, it default-initialises the elements of a container, rather than
+ * value-initialising them. For trivial types, resizing a vector does not write its memory, so that the pages
+ * of a large array are first touched, and placed on the NUMA node, of the threads filling it.
+ */
+template<typename T>
+class LargeArrayAllocator : public std::allocator<T> {
+public:
+    template<typename U> struct rebind { using other = LargeArrayAllocator<U>; };
+
+    LargeArrayAllocator() noexcept = default;
+    template<typename U> LargeArrayAllocator(const LargeArrayAllocator<U>&) noexcept { }
+
+    T* allocate(size_t n){
+        if(n * sizeof(T) >= memory::LARGE_ALLOCATION_THRESHOLD){
+            return static_cast<T*>(memory::allocate_large(n * sizeof(T)));
+        } else {
+            return std::allocator<T>::allocate(n);
+        }
+    }
+
+    void deallocate(T* ptr, size_t n){
+        if(n * sizeof(T) >= memory::LARGE_ALLOCATION_THRESHOLD){
+            memory::deallocate_large(ptr);
+        } else {
+            std::allocator<T>::deallocate(ptr, n);
+        }
+    }
+
+    template<typename U>
+    void construct(U* ptr) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new(static_cast<void*>(ptr)) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) {
+        ::new(static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const LargeArrayAllocator<T>&, const LargeArrayAllocator<U>&) noexcept { return true; }
+template<typename T, typename U>
+bool operator!=(const LargeArrayAllocator<T>&, const LargeArrayAllocator<U>&) noexcept { return false; }
@@ -0,0 +1,180 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "numa.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "lib/common/error.hpp"
+
+using namespace std;
+
+namespace numa {
+
+static bool g_enabled = false; // whether the threads should be pinned
+static vector<int> g_node_ids; // the ID of each node, as seen by the kernel
+static vector<vector<int>> g_cpus; // the CPUs available in each node
+
+// Parse a list of CPUs in the format of sysfs, e.g. 0-3,8,10-11
+static vector<int> parse_cpulist(const string& cpulist){
+    vector<int> result;
+    const char* cursor = cpulist.c_str();
+    while(*cursor != '\0' && *cursor != '\n'){
+        char* end = nullptr;
+        long first = strtol(cursor, &end, 10);
+        long last = first;
+        if(end == cursor) break; // parse error
+        if(*end == '-'){
+            cursor = end +1;
+            last = strtol(cursor, &end, 10);
+        }
+        for(long cpu = first; cpu <= last; cpu++){ result.push_back(cpu); }
+        cursor = end;
+        if(*cursor == ',') cursor++;
+    }
+    return result;
+}
+
+void enable(){
+    cpu_set_t affinity;
+    CPU_ZERO(&affinity);
+    if(sched_getaffinity(0, sizeof(affinity), &affinity) != 0){ ERROR("sched_getaffinity: " << strerror(errno)); }
+
+    g_node_ids.clear();
+    g_cpus.clear();
+    DIR* dir = opendir("/sys/devices/system/node");
+    if(dir != nullptr){
+        struct dirent* entry = nullptr;
+        vector<int> node_ids;
+        while((entry = readdir(dir)) != nullptr){
+            int node_id = 0;
+            if(sscanf(entry->d_name, "node%d", &node_id) == 1){ node_ids.push_back(node_id); }
+        }
+        closedir(dir);
+        sort(begin(node_ids), end(node_ids));
+
+        for(int node_id : node_ids){
+            ifstream in { "/sys/devices/system/node/node" + to_string(node_id) + "/cpulist" };
+            string cpulist;
+            getline(in, cpulist);
+            vector<int> cpus;
+            for(int cpu : parse_cpulist(cpulist)){
+                if(cpu < CPU_SETSIZE && CPU_ISSET(cpu, &affinity)){ cpus.push_back(cpu); }
+            }
+            if(!cpus.empty()){ // memory-only nodes have no cpus
+                g_node_ids.push_back(node_id);
+                g_cpus.push_back(cpus);
+            }
+        }
+    }
+
+    if(g_cpus.empty()){ // no sysfs, treat the machine as a single node
+        vector<int> cpus;
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+            if(CPU_ISSET(cpu, &affinity)){ cpus.push_back(cpu); }
+        }
+        g_node_ids.push_back(0);
+        g_cpus.push_back(cpus);
+    }
+
+    g_enabled = true;
+}
+
+bool is_enabled(){
+    return g_enabled;
+}
+
+int num_nodes(){
+    return g_enabled ? g_cpus.size() : 1;
+}
+
+int num_cpus(){
+    int count = 0;
+    for(auto& cpus : g_cpus){ count += cpus.size(); }
+    return count;
+}
+
+int node_of_thread(int thread_id, int num_threads){
+    return static_cast<int64_t>(thread_id) * num_nodes() / num_threads;
+}
+
+void pin_thread(int thread_id, int num_threads){
+    if(!g_enabled) return;
+    int node = node_of_thread(thread_id, num_threads);
+    int first_thread = (static_cast<int64_t>(node) * num_threads + num_nodes() -1) / num_nodes(); // first thread of the node
+    const vector<int>& cpus = g_cpus[node];
+    int cpu = cpus[(thread_id - first_thread) % cpus.size()];
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    sched_setaffinity(0, sizeof(mask), &mask); // best effort
+}
+
+// The pages fully contained in [address, address + length), false if there are none
+static bool page_range(void* address, size_t length, uintptr_t* out_start, uintptr_t* out_end){
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    *out_start = (reinterpret_cast<uintptr_t>(address) + page_size -1) & ~(page_size -1);
+    *out_end = (reinterpret_cast<uintptr_t>(address) + length) & ~(page_size -1);
+    return *out_start < *out_end;
+}
+
+static constexpr int NODEMASK_BITS = 1024;
+
+// Add the given node to a mask of NODEMASK_BITS bits, false if the ID of the node does not fit in the mask
+static bool add_to_nodemask(unsigned long* nodemask, int node){
+    int node_id = g_node_ids[node];
+    if(node_id >= NODEMASK_BITS) return false;
+    nodemask[node_id / (sizeof(unsigned long) * 8)] |= 1ul << (node_id % (sizeof(unsigned long) * 8));
+    return true;
+}
+
+void bind_memory(void* address, size_t length, int node){
+    uintptr_t start, end;
+    if(!g_enabled || !page_range(address, length, &start, &end)) return;
+
+    unsigned long nodemask[NODEMASK_BITS / (sizeof(unsigned long) * 8)] = {0};
+    if(!add_to_nodemask(nodemask, node)) return;
+    // a preferred policy rather than a strict bind, the kernel can still fall back to other nodes if this one is full
+    syscall(SYS_mbind, start, end - start, MPOL_PREFERRED, nodemask, NODEMASK_BITS, 0); // best effort
+}
+
+void interleave_memory(void* address, size_t length){
+    uintptr_t start, end;
+    if(!g_enabled || num_nodes() <= 1 || !page_range(address, length, &start, &end)) return;
+
+    unsigned long nodemask[NODEMASK_BITS / (sizeof(unsigned long) * 8)] = {0};
+    for(int node = 0; node < num_nodes(); node++){ add_to_nodemask(nodemask, node); }
+    syscall(SYS_mbind, start, end - start, MPOL_INTERLEAVE, nodemask, NODEMASK_BITS, 0); // best effort
+}
+
+int node_id(int node){
+    return (node < (int) g_node_ids.size()) ? g_node_ids[node] : node;
+}
+
+} // namespace numa
@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * NUMA awareness. When enabled, the worker threads of #run_in_parallel are pinned to the CPUs of the machine,
+ * and split in contiguous blocks among the NUMA nodes: with T threads and N nodes, the thread i runs on the
+ * node i * N / T. The threads then first-touch, or explicitly bind, the data they operate on, while the tables
+ * shared by all threads are interleaved among the nodes. Not placed yet: the table of the cuckoo dedup, allocated by
+ * the library, and the list of vertices, read by all writers.
+ *
+ * The topology is read from /sys/devices/system/node and restricted to the CPUs the process can run on.
+ */
+namespace numa {
+
+// Load the topology of the machine and pin the worker threads from now on
+void enable();
+
+// Whether #enable has been invoked
+bool is_enabled();
+
+// Number of NUMA nodes with at least one CPU available to the process
+int num_nodes();
+
+// Number of CPUs available to the process
+int num_cpus();
+
+// The node where the given worker thread runs, out of num_threads workers
+int node_of_thread(int thread_id, int num_threads);
+
+// Pin the calling thread to a CPU of its node. No-op if NUMA awareness is not enabled.
+void pin_thread(int thread_id, int num_threads);
+
+// Ask the kernel to place the pages in [address, address + length) on the given node. Only the pages fully
+// contained in the range are affected. No-op if NUMA awareness is not enabled.
+void bind_memory(void* address, size_t length, int node);
+
+// Ask the kernel to interleave the pages in [address, address + length) among all nodes, for the data shared by all
+// threads. Only the pages not touched yet are affected. No-op if NUMA awareness is not enabled.
+void interleave_memory(void* address, size_t length);
+
+// The ID of the given node, as seen by the kernel
+int node_id(int node);
+
+} // namespace numa
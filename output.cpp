@@ -0,0 +1,845 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "output.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include "lib/common/error.hpp"
+#include "generator.hpp"
+#include "progress.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+/*****************************************************************************
+ *                                                                           *
+ *  Sink                                                                     *
+ *                                                                           *
+ *****************************************************************************/
+
+static OutputSink g_output_sink = OutputSink::FILESYSTEM;
+
+void set_output_sink(OutputSink sink){
+    g_output_sink = sink;
+}
+
+OutputSink get_output_sink(){
+    return g_output_sink;
+}
+
+OutputSink parse_output_sink(const string& value){
+    if(value == "file"){
+        return OutputSink::FILESYSTEM;
+    } else if(value == "null"){
+        return OutputSink::NONE;
+    } else if(value == "memory"){
+        return OutputSink::MEMORY;
+    } else {
+        ERROR("Invalid value for the argument --output_sink: `" << value << "'. Valid values are: file, null and memory");
+    }
+}
+
+static bool g_direct_io = false;
+
+void set_direct_io(bool value){
+    g_direct_io = value;
+}
+
+bool is_direct_io(){
+    return g_direct_io;
+}
+
+static EdgeWeights g_edge_weights;
+
+void set_edge_weights(const EdgeWeights& weights){
+    g_edge_weights = weights;
+}
+
+const EdgeWeights& get_edge_weights(){
+    return g_edge_weights;
+}
+
+const char* to_string(OutputSink sink){
+    switch(sink){
+    case OutputSink::FILESYSTEM: return "file";
+    case OutputSink::NONE: return "null";
+    case OutputSink::MEMORY: return "memory";
+    default: return "unknown";
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  CRC-32                                                                   *
+ *                                                                           *
+ *****************************************************************************/
+
+namespace {
+
+// Lookup tables for the slicing-by-8 algorithm, reflected polynomial 0xEDB88320 as in zlib
+struct Crc32Tables {
+    uint32_t m_table[8][256];
+
+    Crc32Tables(){
+        for(uint32_t i = 0; i < 256; i++){
+            uint32_t crc = i;
+            for(int j = 0; j < 8; j++){ crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1))); }
+            m_table[0][i] = crc;
+        }
+        for(uint32_t i = 0; i < 256; i++){
+            for(int k = 1; k < 8; k++){
+                m_table[k][i] = (m_table[k -1][i] >> 8) ^ m_table[0][m_table[k -1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+} // anonymous namespace
+
+static const Crc32Tables g_crc32;
+
+static uint32_t crc32_update(uint32_t crc, const char* data, uint64_t size){
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    const auto& t = g_crc32.m_table;
+    crc = ~crc;
+    while(size >= 8){
+        uint32_t low, high;
+        memcpy(&low, p, 4); // assume little endian
+        memcpy(&high, p + 4, 4);
+        low ^= crc;
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while(size-- > 0){ crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF]; }
+    return ~crc;
+}
+
+// The CRC-32 of the concatenation of two blocks, given their CRCs and the length of the second block, as
+// crc32_combine in zlib: append len2 zero bytes to the first CRC, by squaring the operator of a zero bit
+static uint32_t gf2_matrix_times(const uint32_t* matrix, uint32_t vector){
+    uint32_t sum = 0;
+    while(vector){
+        if(vector & 1){ sum ^= *matrix; }
+        vector >>= 1;
+        matrix++;
+    }
+    return sum;
+}
+
+static void gf2_matrix_square(uint32_t* square, const uint32_t* matrix){
+    for(int n = 0; n < 32; n++){ square[n] = gf2_matrix_times(matrix, matrix[n]); }
+}
+
+static uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2){
+    if(len2 == 0) return crc1;
+    uint32_t even[32]; // even power of two zeros operator
+    uint32_t odd[32]; // odd power of two zeros operator
+
+    odd[0] = 0xEDB88320u; // operator for one zero bit
+    uint32_t row = 1;
+    for(int n = 1; n < 32; n++){ odd[n] = row; row <<= 1; }
+    gf2_matrix_square(even, odd); // two zero bits
+    gf2_matrix_square(odd, even); // four zero bits
+
+    do { // apply len2 zeros to crc1, the first square puts the operator for one zero byte in even
+        gf2_matrix_square(even, odd);
+        if(len2 & 1){ crc1 = gf2_matrix_times(even, crc1); }
+        len2 >>= 1;
+        if(len2 == 0) break;
+        gf2_matrix_square(odd, even);
+        if(len2 & 1){ crc1 = gf2_matrix_times(odd, crc1); }
+        len2 >>= 1;
+    } while(len2 != 0);
+
+    return crc1 ^ crc2;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Writer                                                                   *
+ *                                                                           *
+ *****************************************************************************/
+
+namespace {
+
+// Release a buffer obtained with posix_memalign
+struct FreeDeleter {
+    void operator()(char* buffer) const { free(buffer); }
+};
+
+} // anonymous namespace
+
+// Pool of buffers, aligned to Writer::BLOCK_SIZE, reused by all writers and released at the exit
+static mutex g_buffer_pool_mutex;
+static vector<unique_ptr<char[], FreeDeleter>> g_buffer_pool;
+
+static char* acquire_buffer(){
+    { // restrict the scope
+        lock_guard<mutex> lock(g_buffer_pool_mutex);
+        if(!g_buffer_pool.empty()){
+            char* buffer = g_buffer_pool.back().release();
+            g_buffer_pool.pop_back();
+            return buffer;
+        }
+    }
+    void* buffer = nullptr;
+    int rc = posix_memalign(&buffer, Writer::BLOCK_SIZE, Writer::BUFFER_SIZE);
+    if(rc != 0) ERROR("Cannot allocate a buffer of " << Writer::BUFFER_SIZE << " bytes: " << strerror(rc));
+    return reinterpret_cast<char*>(buffer);
+}
+
+static void release_buffer(char* buffer){
+    unique_ptr<char[], FreeDeleter> ptr { buffer }; // freed if the pool cannot grow
+    lock_guard<mutex> lock(g_buffer_pool_mutex);
+    g_buffer_pool.push_back(move(ptr));
+}
+
+Writer::Writer(const string& path) : m_path(path), m_sink(g_output_sink), m_buffer(acquire_buffer()) {
+    if(m_sink == OutputSink::FILESYSTEM){
+        if(g_direct_io){
+            m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+            if(m_fd >= 0){
+                m_direct_io = true;
+            } else if(errno == EINVAL){ // O_DIRECT not supported
+                static bool warning_shown = false;
+                if(!warning_shown){
+                    cerr << "[output] O_DIRECT is not supported by the filesystem of `" << path << "', writing through the page cache" << endl;
+                    warning_shown = true;
+                }
+            }
+        }
+        if(m_fd < 0){
+            m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        }
+        if(m_fd < 0){
+            int error = errno;
+            release_buffer(m_buffer); m_buffer = nullptr;
+            ERROR("Cannot create the file `" << path << "': " << strerror(error));
+        }
+    }
+}
+
+Writer::~Writer(){
+    try {
+        close();
+    } catch(...){ /* ignore */ }
+}
+
+void Writer::write_fd(const char* data, uint64_t size){
+    uint64_t offset = 0;
+    while(offset < size){
+        ssize_t rc = ::write(m_fd, data + offset, size - offset);
+        if(rc < 0 && errno == EINTR) continue;
+        if(rc < 0) ERROR("Cannot write the file `" << m_path << "': " << strerror(errno));
+        offset += rc;
+    }
+}
+
+void Writer::flush(){
+    if(m_buffer_used == 0) return;
+    m_checksum = crc32_update(m_checksum, m_buffer, m_buffer_used);
+
+    switch(m_sink){
+    case OutputSink::FILESYSTEM:
+        if(m_direct_io && m_buffer_used % BLOCK_SIZE != 0){ // only the last buffer, pad it to a whole block
+            uint64_t size = (m_buffer_used + BLOCK_SIZE -1) / BLOCK_SIZE * BLOCK_SIZE;
+            memset(m_buffer + m_buffer_used, 0, size - m_buffer_used);
+            write_fd(m_buffer, size);
+        } else {
+            write_fd(m_buffer, m_buffer_used);
+        }
+        break;
+    case OutputSink::MEMORY:
+        m_memory.emplace_back(new char[m_buffer_used]);
+        memcpy(m_memory.back().get(), m_buffer, m_buffer_used);
+        break;
+    default:
+        break; // discard
+    }
+
+    m_buffer_used = 0;
+}
+
+void Writer::write(const char* data, uint64_t size){
+    m_bytes_written += size;
+    while(size > 0){
+        if(m_buffer_used == BUFFER_SIZE) flush();
+        uint64_t length = min(size, BUFFER_SIZE - m_buffer_used);
+        memcpy(m_buffer + m_buffer_used, data, length);
+        m_buffer_used += length;
+        data += length;
+        size -= length;
+    }
+}
+
+void Writer::write(uint64_t value){
+    constexpr uint64_t MAX_DIGITS = 20;
+    if(BUFFER_SIZE - m_buffer_used >= MAX_DIGITS){
+        char* start = m_buffer + m_buffer_used;
+        char* end = to_chars(start, start + MAX_DIGITS, value).ptr;
+        m_buffer_used += end - start;
+        m_bytes_written += end - start;
+    } else { // fill the buffer up to the end, the writes with O_DIRECT must be whole blocks
+        char digits[MAX_DIGITS];
+        char* end = to_chars(digits, digits + MAX_DIGITS, value).ptr;
+        write(digits, end - digits);
+    }
+}
+
+void Writer::write(double value){
+    constexpr uint64_t MAX_CHARS = EdgeWeights::MAX_CHARS;
+    if(BUFFER_SIZE - m_buffer_used >= MAX_CHARS){
+        char* start = m_buffer + m_buffer_used;
+        char* end = to_chars(start, start + MAX_CHARS, value).ptr;
+        m_buffer_used += end - start;
+        m_bytes_written += end - start;
+    } else {
+        char chars[MAX_CHARS];
+        char* end = to_chars(chars, chars + MAX_CHARS, value).ptr;
+        write(chars, end - chars);
+    }
+}
+
+void Writer::preallocate(uint64_t size){
+    if(m_fd < 0 || size == 0) return;
+    int rc = ::fallocate(m_fd, 0, 0, size);
+    if(rc != 0){
+        if(errno == EOPNOTSUPP || errno == ENOSYS) return; // not supported by the filesystem, the blocks are allocated by the writes
+        ERROR("Cannot reserve " << size << " bytes for the file `" << m_path << "': " << strerror(errno));
+    }
+    m_preallocated = size;
+}
+
+void Writer::close(){
+    if(m_buffer == nullptr) return; // already closed
+    flush();
+    release_buffer(m_buffer); m_buffer = nullptr;
+    m_memory.clear();
+    if(m_fd >= 0){
+        // release the space reserved but not used, or remove the padding of the last block with O_DIRECT
+        if((m_preallocated > m_bytes_written || m_direct_io) && ::ftruncate(m_fd, m_bytes_written) != 0){
+            ERROR("Cannot truncate the file `" << m_path << "': " << strerror(errno));
+        }
+        int rc = ::close(m_fd);
+        m_fd = -1;
+        if(rc != 0) ERROR("Cannot close the file `" << m_path << "': " << strerror(errno));
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Vertices & edges                                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+// Number of decimal digits of the given number
+static uint64_t num_digits(uint64_t value){
+    uint64_t result = 1;
+    while(value >= 10){ value /= 10; result++; }
+    return result;
+}
+
+// The weights are computed in batches of this many edges, before formatting them
+constexpr uint64_t WEIGHTS_BATCH = 256;
+
+// Number of characters of the given weight, once formatted
+static uint64_t weight_length(double weight){
+    char chars[EdgeWeights::MAX_CHARS];
+    return to_chars(chars, chars + sizeof(chars), weight).ptr - chars;
+}
+
+// The size, in bytes, of the edges in the range [begin, end) once formatted
+static uint64_t edges_file_size(const vector<uint64_t>& vertices, const edge_list_t& edges, uint64_t begin, uint64_t end){
+    const bool weighted = g_edge_weights.is_weighted();
+    double weights[WEIGHTS_BATCH];
+    uint64_t result = 0;
+    for(uint64_t i = begin; i < end; i += WEIGHTS_BATCH){
+        const uint64_t batch_end = min(end, i + WEIGHTS_BATCH);
+        if(weighted){ g_edge_weights.weights(edges.data() + i, batch_end - i, weights); }
+        for(uint64_t j = i; j < batch_end; j++){
+            const Edge& e = edges[j];
+            result += num_digits(vertices[e.m_source]) + num_digits(vertices[e.m_destination]) + 2; // source, space, destination & new line
+            if(weighted){ result += 1 + weight_length(weights[j - i]); } // space & weight
+        }
+    }
+    return result;
+}
+
+// The average length, in bytes, of the weight of an edge and its leading space, from the weights of a sample of edges
+static double average_weight_length(){
+    if(!g_edge_weights.is_weighted()) return 0;
+    Edge sample[WEIGHTS_BATCH];
+    double weights[WEIGHTS_BATCH];
+    for(uint64_t i = 0; i < WEIGHTS_BATCH; i++){ sample[i] = Edge{ i, i +1 }; }
+    g_edge_weights.weights(sample, WEIGHTS_BATCH, weights);
+    uint64_t num_chars = 0;
+    for(uint64_t i = 0; i < WEIGHTS_BATCH; i++){ num_chars += 1 + weight_length(weights[i]); }
+    return static_cast<double>(num_chars) / WEIGHTS_BATCH;
+}
+
+// The expected size, in bytes, of `num_edges' edges with the endpoints uniformly distributed among the given
+// vertices, once formatted. The vertices are sorted, so the number of IDs with d digits is found by bisection.
+static uint64_t estimate_edges_file_size(const vector<uint64_t>& vertices, uint64_t num_edges){
+    if(vertices.empty()) return 0;
+    uint64_t num_digits_total = 0;
+    uint64_t start = 0; // first vertex with d digits
+    uint64_t threshold = 10; // 10^d
+    for(uint64_t d = 1; start < vertices.size(); d++){
+        uint64_t next = (d == 20) ? vertices.size() : lower_bound(begin(vertices) + start, end(vertices), threshold) - begin(vertices); // first vertex with d +1 digits
+        num_digits_total += (next - start) * d;
+        start = next;
+        threshold *= 10;
+    }
+    double avg_line = 2.0 * num_digits_total / vertices.size() + 2 + average_weight_length(); // source, space, destination, new line & weight
+    return static_cast<uint64_t>(ceil(num_edges * avg_line));
+}
+
+// Whether the writer for the given path creates a regular file, worth preallocating
+static bool out_is_file(const string& path){
+    return g_output_sink == OutputSink::FILESYSTEM && path != "/dev/null";
+}
+
+// The path of a part of the edge file, path + suffix, or /dev/null itself if the edges are discarded
+static string get_part_path(const string& path, const char* suffix){
+    return (path == "/dev/null") ? path : path + suffix;
+}
+
+// Sum the bytes read & written by each worker thread by NUMA node. A single thread is not pinned and is not counted.
+static void set_bytes_per_node(const vector<uint64_t>& bytes_per_thread, vector<size_t>* out_bytes_per_node){
+    if(out_bytes_per_node == nullptr) return;
+    out_bytes_per_node->assign(numa::num_nodes(), 0);
+    if(bytes_per_thread.size() <= 1) return;
+    for(size_t t = 0; t < bytes_per_thread.size(); t++){
+        (*out_bytes_per_node)[numa::node_of_thread(t, bytes_per_thread.size())] += bytes_per_thread[t];
+    }
+}
+
+vector<uint64_t> make_vertices(uint64_t num_vertices, double exp_factor){
+    vector<uint64_t> vertices;
+    vertices.reserve(num_vertices);
+    vertices.push_back(1); // the first vertex is always 1
+    uint64_t vertex_id = 1;
+    while(vertices.size() < num_vertices){
+        if(vertex_id >= exp_factor * vertices.size()){
+            vertices.push_back(vertex_id +1 /* because we started from 1 */);
+        }
+        vertex_id++;
+    }
+
+    return vertices;
+}
+
+uint64_t save_vertices(const string& path, const vector<uint64_t>& vertices, uint32_t* out_checksum){
+    Writer out { path };
+    if(out_is_file(path)){
+        uint64_t size = 0;
+        for(auto v : vertices){ size += num_digits(v) +1; }
+        out.preallocate(size);
+    }
+    progress::Counters& counters = progress::counters(0);
+    for(auto v: vertices){
+        out.write(v);
+        out.write('\n');
+    }
+    out.close();
+    progress::Counters::add(counters.m_bytes_written, out.bytes_written());
+    if(out_checksum != nullptr){ *out_checksum = out.checksum(); }
+    return out.bytes_written();
+}
+
+// A range [first, second) of positions in the list of edges
+using EdgeRange = pair<uint64_t, uint64_t>;
+
+// Write the edges in the given ranges in the given file, `num_edges' being their total
+static uint64_t save_edges(const string& path, const vector<uint64_t>& vertices, const edge_list_t& edges, const vector<EdgeRange>& ranges, uint64_t num_edges, progress::Counters& counters, uint32_t* out_checksum){
+    Writer out { path };
+    const bool weighted = g_edge_weights.is_weighted();
+    if(out_is_file(path)){ // only a hint, the space not used is released when the file is closed
+        out.preallocate(estimate_edges_file_size(vertices, num_edges));
+    }
+    constexpr uint64_t TRACE_CHUNK = 1ull << 20; // number of edges in each span of the trace and in each progress update
+    uint64_t bytes_written = 0;
+    uint64_t chunk_size = 0; // number of edges written in the current chunk
+    unique_ptr<trace::Span> span; // of the current chunk
+    double weights[WEIGHTS_BATCH];
+    for(const EdgeRange& range : ranges){
+        for(uint64_t i = range.first; i < range.second; ){
+            if(span == nullptr){ span.reset(new trace::Span("write.edges", i)); }
+            const uint64_t batch_end = min(range.second, i + min(WEIGHTS_BATCH, TRACE_CHUNK - chunk_size));
+            if(weighted){ g_edge_weights.weights(edges.data() + i, batch_end - i, weights); }
+            for(uint64_t k = i; k < batch_end; k++){
+                const Edge& e = edges[k];
+                assert(e.m_source < vertices.size());
+                assert(e.m_destination < vertices.size());
+                out.write(vertices[e.m_source]);
+                out.write(' ');
+                out.write(vertices[e.m_destination]);
+                if(weighted){
+                    out.write(' ');
+                    out.write(weights[k - i]);
+                }
+                out.write('\n');
+            }
+            chunk_size += batch_end - i;
+            i = batch_end;
+
+            if(chunk_size == TRACE_CHUNK){
+                progress::Counters::add(counters.m_bytes_written, out.bytes_written() - bytes_written);
+                bytes_written = out.bytes_written();
+                chunk_size = 0;
+                span.reset();
+            }
+        }
+    }
+    progress::Counters::add(counters.m_bytes_written, out.bytes_written() - bytes_written);
+    span.reset();
+    out.close();
+    if(out_checksum != nullptr){ *out_checksum = out.checksum(); }
+    return out.bytes_written();
+}
+
+uint64_t save_edges(const string& path, const vector<uint64_t>& vertices, const edge_list_t& edges, uint32_t* out_checksum){
+    return save_edges(path, vertices, edges, { EdgeRange{ 0, edges.size() } }, edges.size(), progress::counters(0), out_checksum);
+}
+
+vector<EdgeShard> save_edges_sharded(const string& path, const vector<uint64_t>& vertices, const edge_list_t& edges, uint64_t num_shards, int num_threads, uint32_t* out_checksum, vector<size_t>* out_bytes_per_node){
+    num_shards = max<uint64_t>(1, num_shards);
+    num_threads = max(1, num_threads);
+
+    // split the edges at the boundaries of the sources
+    vector<uint64_t> boundaries(num_shards +1);
+    boundaries[0] = 0;
+    boundaries[num_shards] = edges.size();
+    for(uint64_t i = 1; i < num_shards; i++){
+        uint64_t position = max<uint64_t>(boundaries[i -1], (unsigned __int128) edges.size() * i / num_shards);
+        if(position > 0 && position < edges.size()){ // move to the first edge of the next source
+            const uint64_t source = edges[position -1].m_source;
+            position = partition_point(begin(edges) + position, end(edges), [source](const Edge& e){ return e.m_source == source; }) - begin(edges);
+        }
+        boundaries[i] = position;
+    }
+
+    vector<EdgeShard> shards(num_shards);
+    for(uint64_t i = 0; i < num_shards; i++){
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%04" PRIu64, i);
+        shards[i].m_path = get_part_path(path, suffix);
+        shards[i].m_num_edges = boundaries[i +1] - boundaries[i];
+    }
+
+    // an exception cannot leave a worker thread
+    mutex error_mutex;
+    exception_ptr error;
+    const int num_workers = min<uint64_t>(num_threads, num_shards);
+    vector<uint64_t> bytes_per_thread(num_workers, 0);
+    run_in_parallel(num_workers, [&](int thread_id){
+        progress::Counters& counters = progress::counters(thread_id);
+        ThreadItems items = items_of_thread(num_shards, thread_id, num_workers);
+        for(uint64_t i = items.m_first; i < items.m_last; i += items.m_step){
+            try {
+                EdgeShard& shard = shards[i];
+                shard.m_bytes_written = save_edges(shard.m_path, vertices, edges, { EdgeRange{ boundaries[i], boundaries[i +1] } }, shard.m_num_edges, counters, &shard.m_checksum);
+                bytes_per_thread[thread_id] += shard.m_num_edges * sizeof(Edge) + shard.m_bytes_written;
+            } catch(...) {
+                lock_guard<mutex> lock(error_mutex);
+                if(!error){ error = current_exception(); }
+                return;
+            }
+        }
+    });
+    if(error){ rethrow_exception(error); }
+    set_bytes_per_node(bytes_per_thread, out_bytes_per_node);
+
+    if(out_checksum != nullptr){
+        uint32_t checksum = 0;
+        for(auto& shard : shards){ checksum = crc32_combine(checksum, shard.m_checksum, shard.m_bytes_written); }
+        *out_checksum = checksum;
+    }
+
+    return shards;
+}
+
+static vector<uint64_t> split_vertices(uint64_t num_vertices, uint64_t num_parts){
+    vector<uint64_t> boundaries(num_parts +1);
+    for(uint64_t i = 0; i <= num_parts; i++){ boundaries[i] = (unsigned __int128) num_vertices * i / num_parts; }
+    return boundaries;
+}
+
+GridPartitioning make_grid_partitioning(uint64_t num_vertices, uint64_t num_rows, uint64_t num_columns, bool whole_matrix){
+    num_rows = max<uint64_t>(1, num_rows);
+    num_columns = max<uint64_t>(1, num_columns);
+    GridPartitioning grid;
+    if(whole_matrix){ // all vertices have the same expected degree
+        grid.m_rows = split_vertices(num_vertices, num_rows);
+        grid.m_columns = split_vertices(num_vertices, num_columns);
+    } else {
+        grid.m_rows = split_sources(num_vertices, num_rows);
+        grid.m_columns = (num_columns == 1) ? vector<uint64_t>{ 0, num_vertices } : split_destinations(num_vertices, num_columns);
+    }
+    return grid;
+}
+
+vector<EdgeShard> save_edges_partitioned(const string& path, const vector<uint64_t>& vertices, const edge_list_t& edges, const GridPartitioning& grid, int num_threads, vector<size_t>* out_bytes_per_node){
+    num_threads = max(1, num_threads);
+    const uint64_t num_blocks = grid.num_blocks();
+
+    // the edges of each row
+    vector<uint64_t> rows(grid.num_rows() +1);
+    for(uint64_t i = 0; i <= grid.num_rows(); i++){
+        const uint64_t source = grid.m_rows[i];
+        rows[i] = partition_point(begin(edges), end(edges), [source](const Edge& e){ return e.m_source < source; }) - begin(edges);
+    }
+
+    // with more than one column, the first edge of each source, scanning each row once. The edges of a source are
+    // sorted by destination, so they are cut by column with a bisection, rather than scanning the row for each block.
+    vector<uint64_t> sources;
+    if(grid.num_columns() > 1){
+        const uint64_t num_vertices = grid.m_rows.back();
+        sources.resize(num_vertices +1);
+        sources[num_vertices] = edges.size();
+        const int num_workers = min<uint64_t>(num_threads, grid.num_rows());
+        run_in_parallel(num_workers, [&](int thread_id){
+            for(uint64_t row = thread_id; row < grid.num_rows(); row += num_workers){
+                uint64_t position = rows[row];
+                for(uint64_t source = grid.m_rows[row]; source < grid.m_rows[row +1]; source++){
+                    while(position < rows[row +1] && edges[position].m_source < source){ position++; }
+                    sources[source] = position;
+                }
+            }
+        });
+    }
+
+    vector<EdgeShard> blocks(num_blocks);
+    for(uint64_t i = 0; i < num_blocks; i++){
+        char suffix[64];
+        if(grid.num_columns() == 1){
+            snprintf(suffix, sizeof(suffix), ".1d.%04" PRIu64, i);
+        } else {
+            snprintf(suffix, sizeof(suffix), ".2d.%04" PRIu64 ".%04" PRIu64, i / grid.num_columns(), i % grid.num_columns());
+        }
+        blocks[i].m_path = get_part_path(path, suffix);
+    }
+
+    // an exception cannot leave a worker thread
+    mutex error_mutex;
+    exception_ptr error;
+    const int num_workers = min<uint64_t>(num_threads, num_blocks);
+    vector<uint64_t> bytes_per_thread(num_workers, 0);
+    run_in_parallel(num_workers, [&](int thread_id){
+        progress::Counters& counters = progress::counters(thread_id);
+        vector<EdgeRange> ranges; // the edges of the block
+        auto by_destination = [](const Edge& e, uint64_t destination){ return e.m_destination < destination; };
+        ThreadItems items = items_of_thread(num_blocks, thread_id, num_workers);
+        for(uint64_t i = items.m_first; i < items.m_last; i += items.m_step){
+            try {
+                EdgeShard& block = blocks[i];
+                const uint64_t row = i / grid.num_columns(), column = i % grid.num_columns();
+                ranges.clear();
+                block.m_num_edges = 0;
+                if(grid.num_columns() == 1){
+                    ranges.emplace_back(rows[row], rows[row +1]);
+                    block.m_num_edges = rows[row +1] - rows[row];
+                } else {
+                    for(uint64_t source = grid.m_rows[row]; source < grid.m_rows[row +1]; source++){
+                        auto first = lower_bound(begin(edges) + sources[source], begin(edges) + sources[source +1], grid.m_columns[column], by_destination);
+                        auto last = lower_bound(first, begin(edges) + sources[source +1], grid.m_columns[column +1], by_destination);
+                        if(first == last) continue;
+                        ranges.emplace_back(first - begin(edges), last - begin(edges));
+                        block.m_num_edges += last - first;
+                    }
+                }
+                block.m_bytes_written = save_edges(block.m_path, vertices, edges, ranges, block.m_num_edges, counters, &block.m_checksum);
+                bytes_per_thread[thread_id] += block.m_num_edges * sizeof(Edge) + block.m_bytes_written;
+            } catch(...) {
+                lock_guard<mutex> lock(error_mutex);
+                if(!error){ error = current_exception(); }
+                return;
+            }
+        }
+    });
+    if(error){ rethrow_exception(error); }
+    set_bytes_per_node(bytes_per_thread, out_bytes_per_node);
+
+    return blocks;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Size of the output files                                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+// The ID of the vertex in the given position, as created by #make_vertices: for k > 0, the vertex is pushed when
+// the counter (ID - 1) first reaches exp_factor * k
+static uint64_t vertex_id(uint64_t position, double exp_factor){
+    if(position == 0) return 1;
+    return static_cast<uint64_t>(ceil(exp_factor * position)) +1;
+}
+
+uint64_t vertices_file_size(uint64_t num_vertices, double exp_factor){
+    // the IDs are increasing, search the first vertex with d +1 digits
+    uint64_t result = 0;
+    uint64_t start = 0; // first vertex with d digits
+    uint64_t threshold = 10; // 10^d
+    for(uint64_t d = 1; start < num_vertices; d++){
+        uint64_t low = start, high = num_vertices;
+        while(low < high){
+            uint64_t mid = low + (high - low) / 2;
+            if(vertex_id(mid, exp_factor) < threshold){ low = mid +1; } else { high = mid; }
+        }
+        result += (low - start) * (d +1); // digits + new line
+        start = low;
+        if(threshold > numeric_limits<uint64_t>::max() / 10){ // 20 digits
+            result += (num_vertices - start) * (d +2);
+            break;
+        }
+        threshold *= 10;
+    }
+    return result;
+}
+
+uint64_t estimate_edges_file_size(uint64_t num_vertices, uint64_t num_edges, double exp_factor){
+    if(num_vertices == 0) return 0;
+    double avg_digits = static_cast<double>(vertices_file_size(num_vertices, exp_factor) - num_vertices) / num_vertices;
+    double avg_line = 2 * avg_digits + 2 + average_weight_length(); // source, space, destination, new line & weight
+    return static_cast<uint64_t>(ceil(num_edges * avg_line));
+}
+
+uint64_t edges_file_size(const vector<uint64_t>& vertices, const edge_list_t& edges){
+    return edges_file_size(vertices, edges, 0, edges.size());
+}
+
+void check_free_space(const string& path, uint64_t num_bytes){
+    struct statvfs info;
+    if(statvfs(path.c_str(), &info) != 0){ ERROR("Cannot retrieve the free space of `" << path << "': " << strerror(errno)); }
+    uint64_t available = static_cast<uint64_t>(info.f_bavail) * info.f_frsize;
+    if(available < num_bytes){
+        ERROR("Not enough space in the filesystem of `" << path << "': " << num_bytes << " bytes required, " << available << " bytes available");
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Memory mapped writer                                                     *
+ *                                                                           *
+ *****************************************************************************/
+
+uint64_t save_edges_mmap(const string& path, const vector<uint64_t>& vertices, const edge_list_t& edges, int num_threads, uint32_t* out_checksum, vector<size_t>* out_bytes_per_node){
+    if(!out_is_file(path) || edges.empty()){ return save_edges(path, vertices, edges, out_checksum); }
+    num_threads = max(1, num_threads);
+    constexpr uint64_t CHUNK_SIZE = 1ull << 20; // number of edges in each chunk, each chunk is a span of the trace
+    const uint64_t num_chunks = (edges.size() + CHUNK_SIZE -1) / CHUNK_SIZE;
+    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    const bool weighted = g_edge_weights.is_weighted();
+
+    // offsets of the chunks in the file
+    vector<uint64_t> offsets(num_chunks +1, 0);
+    run_in_parallel(num_threads, [&](int thread_id){
+        ThreadItems chunks = items_of_thread(num_chunks, thread_id, num_threads);
+        for(uint64_t c = chunks.m_first; c < chunks.m_last; c += chunks.m_step){
+            trace::Span span { "write.size", c * CHUNK_SIZE };
+            offsets[c +1] = edges_file_size(vertices, edges, c * CHUNK_SIZE, min<uint64_t>(edges.size(), (c +1) * CHUNK_SIZE));
+        }
+    });
+    for(uint64_t c = 0; c < num_chunks; c++){ offsets[c +1] += offsets[c]; }
+    const uint64_t file_size = offsets[num_chunks];
+
+    // size & map the file
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) ERROR("Cannot create the file `" << path << "': " << strerror(errno));
+    if(::fallocate(fd, 0, 0, file_size) != 0){
+        if(errno != EOPNOTSUPP && errno != ENOSYS){ int error = errno; ::close(fd); ERROR("Cannot reserve " << file_size << " bytes for the file `" << path << "': " << strerror(error)); }
+        if(::ftruncate(fd, file_size) != 0){ int error = errno; ::close(fd); ERROR("Cannot resize the file `" << path << "': " << strerror(error)); }
+    }
+    char* content = reinterpret_cast<char*>(mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    if(content == MAP_FAILED){ int error = errno; ::close(fd); ERROR("Cannot map the file `" << path << "': " << strerror(error)); }
+
+    // format the chunks
+    vector<uint32_t> checksums(num_chunks);
+    vector<uint64_t> bytes_per_thread(num_threads, 0);
+    run_in_parallel(num_threads, [&](int thread_id){
+        progress::Counters& counters = progress::counters(thread_id);
+        ThreadItems chunks = items_of_thread(num_chunks, thread_id, num_threads);
+        for(uint64_t c = chunks.m_first; c < chunks.m_last; c += chunks.m_step){
+            trace::Span span { "write.edges", c * CHUNK_SIZE };
+            char* const start = content + offsets[c];
+            char* const limit = content + offsets[c +1];
+            char* position = start;
+            const uint64_t end = min<uint64_t>(edges.size(), (c +1) * CHUNK_SIZE);
+            double weights[WEIGHTS_BATCH];
+            for(uint64_t i = c * CHUNK_SIZE; i < end; i += WEIGHTS_BATCH){
+                const uint64_t batch_end = min(end, i + WEIGHTS_BATCH);
+                if(weighted){ g_edge_weights.weights(edges.data() + i, batch_end - i, weights); }
+                for(uint64_t j = i; j < batch_end; j++){
+                    const Edge& e = edges[j];
+                    assert(e.m_source < vertices.size());
+                    assert(e.m_destination < vertices.size());
+                    position = to_chars(position, limit, vertices[e.m_source]).ptr;
+                    *(position++) = ' ';
+                    position = to_chars(position, limit, vertices[e.m_destination]).ptr;
+                    if(weighted){
+                        *(position++) = ' ';
+                        position = to_chars(position, limit, weights[j - i]).ptr;
+                    }
+                    *(position++) = '\n';
+                }
+            }
+            assert(position == limit);
+            checksums[c] = crc32_update(0, start, limit - start);
+            progress::Counters::add(counters.m_bytes_written, limit - start);
+            bytes_per_thread[thread_id] += (end - c * CHUNK_SIZE) * sizeof(Edge) + (limit - start);
+
+            // start the writeback of the chunk and release the pages entirely owned by the chunk
+            sync_file_range(fd, offsets[c], offsets[c +1] - offsets[c], SYNC_FILE_RANGE_WRITE);
+            uint64_t page_start = (offsets[c] + page_size -1) / page_size * page_size;
+            uint64_t page_end = offsets[c +1] / page_size * page_size;
+            if(page_start < page_end){ madvise(content + page_start, page_end - page_start, MADV_DONTNEED); }
+        }
+    });
+
+    int rc_unmap = munmap(content, file_size);
+    int error = errno;
+    int rc_close = ::close(fd);
+    if(rc_unmap != 0) ERROR("Cannot unmap the file `" << path << "': " << strerror(error));
+    if(rc_close != 0) ERROR("Cannot close the file `" << path << "': " << strerror(errno));
+    set_bytes_per_node(bytes_per_thread, out_bytes_per_node);
+
+    if(out_checksum != nullptr){
+        uint32_t checksum = 0;
+        for(uint64_t c = 0; c < num_chunks; c++){ checksum = crc32_combine(checksum, checksums[c], offsets[c +1] - offsets[c]); }
+        *out_checksum = checksum;
+    }
+
+    return file_size;
+}
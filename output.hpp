@@ -0,0 +1,233 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "edge.hpp"
+#include "weights.hpp"
+
+// Where the writers send the bytes of the output files
+enum class OutputSink {
+    FILESYSTEM, // write the files
+    NONE, // format the content and compute the checksum, but discard the bytes
+    MEMORY, // copy the bytes into a buffer in main memory, released when the file is closed
+};
+
+// Set the sink for all output files. The default is OutputSink::FILESYSTEM
+void set_output_sink(OutputSink sink);
+
+// Retrieve the sink for the output files
+OutputSink get_output_sink();
+
+// Parse the value of the argument --output_sink: file, null or memory
+OutputSink parse_output_sink(const std::string& value);
+
+// String representation of the sink
+const char* to_string(OutputSink sink);
+
+// Whether the files should be written with O_DIRECT, bypassing the page cache. The default is false
+void set_direct_io(bool value);
+
+// Check whether the files are written with O_DIRECT
+bool is_direct_io();
+
+// Set the weights appended to each edge, `source destination weight', by all the edge writers. The default is unweighted
+void set_edge_weights(const EdgeWeights& weights);
+
+// Retrieve the weights of the edges
+const EdgeWeights& get_edge_weights();
+
+/**
+ * Buffered writer of an output file, sending the bytes to the sink set by #set_output_sink. It also computes the
+ * CRC-32 of the content, the same as zlib, so that the output of the different sinks can be compared.
+ *
+ * The buffers are aligned to the page size and taken from a pool shared by all writers, so that they can also be
+ * used for O_DIRECT. With #set_direct_io, the full buffers are written directly to the device and the last
+ * partial block is padded with zeros and then truncated when the file is closed. If the filesystem does not
+ * support O_DIRECT, the writer falls back to the page cache.
+ */
+class Writer {
+    const std::string m_path; // the file being written
+    const OutputSink m_sink; // where to send the bytes
+    int m_fd = -1; // file descriptor, only for OutputSink::FILESYSTEM
+    bool m_direct_io = false; // whether the file was opened with O_DIRECT
+    char* m_buffer = nullptr; // bytes formatted but not flushed yet, from the pool
+    uint64_t m_buffer_used = 0; // number of bytes in the buffer
+    std::vector<std::unique_ptr<char[]>> m_memory; // content of the file, only for OutputSink::MEMORY
+    uint64_t m_bytes_written = 0; // total number of bytes written so far, including those in the buffer
+    uint32_t m_checksum = 0; // crc32 of the bytes flushed so far
+    uint64_t m_preallocated = 0; // the space reserved with #preallocate, in bytes
+
+    // Send the content of the buffer to the sink
+    void flush();
+
+    // Write the given bytes to the file, handling the partial writes
+    void write_fd(const char* data, uint64_t size);
+
+public:
+    static constexpr uint64_t BUFFER_SIZE = 1ull << 20; // capacity of the buffer, in bytes
+    static constexpr uint64_t BLOCK_SIZE = 4096; // alignment of the buffers and of the writes with O_DIRECT
+
+    // Create the file
+    Writer(const std::string& path);
+
+    // Close the file, if not already done
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    // Append the given bytes
+    void write(const char* data, uint64_t size);
+
+    // Append a single character
+    void write(char c){
+        if(m_buffer_used == BUFFER_SIZE) flush();
+        m_buffer[m_buffer_used++] = c;
+        m_bytes_written++;
+    }
+
+    // Append the decimal representation of the given number
+    void write(uint64_t value);
+
+    // Append the shortest representation of the given number that parses back to the same value
+    void write(double value);
+
+    // Reserve the space for a file of the given size, so that the writes do not need to allocate the blocks.
+    // Only for OutputSink::FILESYSTEM, no-op if the filesystem does not support fallocate(2).
+    void preallocate(uint64_t size);
+
+    // Flush the buffer and close the file. Further invocations are ignored.
+    void close();
+
+    // Total number of bytes written so far
+    uint64_t bytes_written() const { return m_bytes_written; }
+
+    // Whether the file is written with O_DIRECT
+    bool is_direct_io() const { return m_direct_io; }
+
+    // The CRC-32 of the whole content, only valid after #close
+    uint32_t checksum() const { return m_checksum; }
+};
+
+/**
+ * Create the list of vertex IDs, in increasing order. The first vertex is always 1 and the IDs are spread in
+ * the domain [1, exp_factor * num_vertices].
+ */
+std::vector<uint64_t> make_vertices(uint64_t num_vertices, double exp_factor);
+
+/**
+ * Save the list of vertices in the given path, one vertex per line. Return the number of bytes written.
+ * If out_checksum is not null, also return the CRC-32 of the content.
+ */
+uint64_t save_vertices(const std::string& path, const std::vector<uint64_t>& vertices, uint32_t* out_checksum = nullptr);
+
+/**
+ * Save the list of edges in the given path, one edge `source destination' per line, translating the
+ * positions of the vertices into their IDs, followed by the weight of the edge if set by #set_edge_weights.
+ * Return the number of bytes written.
+ * If out_checksum is not null, also return the CRC-32 of the content.
+ */
+uint64_t save_edges(const std::string& path, const std::vector<uint64_t>& vertices, const edge_list_t& edges, uint32_t* out_checksum = nullptr);
+
+/**
+ * Same as #save_edges, but the file is sized upfront and memory mapped, and `num_threads' threads format the
+ * edges in parallel directly into the mapping. The edges are split in chunks, the offset of each chunk in the
+ * file is computed in advance from the digits of its vertices. As soon as a chunk is complete, its pages are
+ * scheduled for writeback and released from the address space, so that the resident memory does not grow with
+ * the file. It requires OutputSink::FILESYSTEM and a regular file, otherwise it falls back to #save_edges.
+ * With NUMA awareness enabled, each thread formats a contiguous block of chunks, rather than one chunk every
+ * `num_threads'. If `out_bytes_per_node' is not null, it reports the bytes of edges read and of text written by the
+ * threads of each node, as #sort_edges.
+ */
+uint64_t save_edges_mmap(const std::string& path, const std::vector<uint64_t>& vertices, const edge_list_t& edges, int num_threads, uint32_t* out_checksum = nullptr, std::vector<size_t>* out_bytes_per_node = nullptr);
+
+// A part of the edge file written by #save_edges_sharded or #save_edges_partitioned
+struct EdgeShard {
+    std::string m_path; // the file of the shard
+    uint64_t m_num_edges = 0; // number of edges in the shard
+    uint64_t m_bytes_written = 0; // size of the file
+    uint32_t m_checksum = 0; // CRC-32 of the content
+};
+
+/**
+ * Save the list of edges, sorted by source, in `num_shards' files, path.0000, path.0001, ... The edges are split
+ * at the boundaries of the sources, so that each shard is sorted and the shards cover disjoint ranges of sources,
+ * with about the same number of edges. The shards are written in parallel by `num_threads' threads.
+ * If out_checksum is not null, also return the CRC-32 of the concatenation of all shards, the same as #save_edges.
+ * If the path is /dev/null, all shards are written to /dev/null. The NUMA placement and `out_bytes_per_node' are
+ * the same as #save_edges_mmap, by shard rather than by chunk.
+ */
+std::vector<EdgeShard> save_edges_sharded(const std::string& path, const std::vector<uint64_t>& vertices, const edge_list_t& edges, uint64_t num_shards, int num_threads, uint32_t* out_checksum = nullptr, std::vector<size_t>* out_bytes_per_node = nullptr);
+
+/**
+ * A partitioning of the adjacency matrix in a grid of blocks, for the distributed graph systems. The rows are ranges
+ * of sources and the columns ranges of destinations, both as positions in the list of vertices. A grid with a
+ * single column is a 1D partitioning by source.
+ */
+struct GridPartitioning {
+    std::vector<uint64_t> m_rows; // the row i covers the sources [m_rows[i], m_rows[i +1])
+    std::vector<uint64_t> m_columns; // the column j covers the destinations [m_columns[j], m_columns[j +1])
+
+    uint64_t num_rows() const { return m_rows.size() -1; }
+    uint64_t num_columns() const { return m_columns.size() -1; }
+    uint64_t num_blocks() const { return num_rows() * num_columns(); }
+};
+
+// Split the adjacency matrix in num_rows x num_columns blocks, with about the same number of possible edges in each
+// row and in each column. If only the edges (u, v), u < v, are stored, the blocks below the diagonal are empty,
+// otherwise, with `whole_matrix', e.g. for symmetric or directed edges, the rows and the columns are ranges with
+// the same number of vertices.
+GridPartitioning make_grid_partitioning(uint64_t num_vertices, uint64_t num_rows, uint64_t num_columns, bool whole_matrix = false);
+
+/**
+ * Save the list of edges, sorted by source, in one file for each block of the grid, in row major order:
+ * path.1d.0000, path.1d.0001, ... with a single column, or path.2d.0000.0000, path.2d.0000.0001, ... otherwise.
+ * Each file is sorted. The blocks are written in parallel by `num_threads' threads. If the path is /dev/null, all
+ * blocks are written to /dev/null. The NUMA placement and `out_bytes_per_node' are the same as #save_edges_mmap,
+ * by block rather than by chunk.
+ */
+std::vector<EdgeShard> save_edges_partitioned(const std::string& path, const std::vector<uint64_t>& vertices, const edge_list_t& edges, const GridPartitioning& grid, int num_threads, std::vector<size_t>* out_bytes_per_node = nullptr);
+
+/**
+ * The exact size, in bytes, of the vertex file created by #save_vertices for the list of vertices of #make_vertices.
+ * The ID of a vertex only depends on its position, so this is also the size of the first num_vertices of any list.
+ */
+uint64_t vertices_file_size(uint64_t num_vertices, double exp_factor);
+
+/**
+ * The expected size, in bytes, of the edge file of a uniform graph, before generating its edges. The endpoints of
+ * the edges are uniformly distributed among the vertices, so each endpoint has on average the same number of
+ * digits of a vertex ID. The size of the weights is estimated from a sample.
+ */
+uint64_t estimate_edges_file_size(uint64_t num_vertices, uint64_t num_edges, double exp_factor);
+
+/**
+ * The exact size, in bytes, of the edge file created by #save_edges
+ */
+uint64_t edges_file_size(const std::vector<uint64_t>& vertices, const edge_list_t& edges);
+
+/**
+ * Check that the filesystem of the given path has at least `num_bytes' available, raise an error otherwise
+ */
+void check_free_space(const std::string& path, uint64_t num_bytes);
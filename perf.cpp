@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "perf.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace perf {
+
+static bool g_enabled = false; // whether the phases should be measured
+static bool g_unavailable_reported[NUM_EVENTS] = {}; // whether we already warned that the event is not available
+
+// Set the type and the configuration of the given event, for perf_event_open
+static void set_event_config(Event event, struct perf_event_attr* attr){
+    switch(event){
+    case CYCLES:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case INSTRUCTIONS:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case LLC_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case DTLB_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case BRANCH_MISSES:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    default:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = 0;
+    }
+}
+
+static int open_counter(Event event){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    set_event_config(event, &attr);
+    attr.disabled = 1;
+    attr.inherit = 1; // account the threads created while the counter is open
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    int fd = syscall(SYS_perf_event_open, &attr, /* this process */ 0, /* any cpu */ -1, /* no group */ -1, 0);
+    if(fd < 0 && !g_unavailable_reported[event]){
+        cerr << "[perf] Cannot open the counter for " << to_string(event) << " (" << strerror(errno) << ")";
+        if(errno == EACCES || errno == EPERM){ cerr << ", check /proc/sys/kernel/perf_event_paranoid"; }
+        cerr << endl;
+        g_unavailable_reported[event] = true;
+    }
+    return fd;
+}
+
+CounterSet::CounterSet(){
+    for(int i = 0; i < NUM_EVENTS; i++){
+        m_fds[i] = open_counter(static_cast<Event>(i));
+    }
+}
+
+CounterSet::~CounterSet(){
+    for(int i = 0; i < NUM_EVENTS; i++){
+        if(m_fds[i] >= 0) close(m_fds[i]);
+    }
+}
+
+void CounterSet::start(){
+    for(int i = 0; i < NUM_EVENTS; i++){
+        if(m_fds[i] < 0) continue;
+        ioctl(m_fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+Counters CounterSet::stop(){
+    Counters result;
+    for(int i = 0; i < NUM_EVENTS; i++){
+        if(m_fds[i] < 0) continue;
+        ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        uint64_t buffer[3]; // value, time enabled, time running
+        if(read(m_fds[i], buffer, sizeof(buffer)) != sizeof(buffer)) continue;
+        uint64_t value = buffer[0];
+        if(buffer[2] == 0 && buffer[1] > 0){ // the counter was never scheduled on the PMU
+            continue;
+        } else if(buffer[2] < buffer[1]){ // multiplexed, extrapolate
+            value = static_cast<uint64_t>(static_cast<double>(value) * buffer[1] / buffer[2]);
+        }
+        result.m_values[i] = value;
+        result.m_available[i] = true;
+    }
+    return result;
+}
+
+void enable(){
+    g_enabled = true;
+}
+
+bool is_enabled(){
+    return g_enabled;
+}
+
+const char* to_string(Event event){
+    switch(event){
+    case CYCLES: return "cycles";
+    case INSTRUCTIONS: return "instructions";
+    case LLC_MISSES: return "llc_misses";
+    case DTLB_MISSES: return "dtlb_misses";
+    case BRANCH_MISSES: return "branch_misses";
+    default: return "unknown";
+    }
+}
+
+} // namespace perf
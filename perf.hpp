@@ -0,0 +1,75 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Hardware performance counters, read through perf_event_open. The counters are opened for the calling
+ * thread and inherited by the threads it creates afterwards, so that the worker threads of #run_in_parallel
+ * are accounted as well, once they terminate. Only user space events are counted.
+ */
+namespace perf {
+
+enum Event {
+    CYCLES,
+    INSTRUCTIONS,
+    LLC_MISSES, // last level cache, read misses
+    DTLB_MISSES, // data TLB, read misses
+    BRANCH_MISSES,
+    NUM_EVENTS // number of events, not an event itself
+};
+
+struct Counters {
+    uint64_t m_values[NUM_EVENTS] = {}; // the value of each event, scaled if the counter was multiplexed
+    bool m_available[NUM_EVENTS] = {}; // whether the event could be measured
+};
+
+/**
+ * A set of counters, one for each event, counting from #start until #stop
+ */
+class CounterSet {
+    int m_fds[NUM_EVENTS]; // file descriptors from perf_event_open, -1 if the event is not available
+
+public:
+    // Open the counters, initially disabled. Counters that cannot be opened are reported as not available.
+    CounterSet();
+
+    // Close the counters
+    ~CounterSet();
+
+    CounterSet(const CounterSet&) = delete;
+    CounterSet& operator=(const CounterSet&) = delete;
+
+    // Reset and enable the counters
+    void start();
+
+    // Disable the counters and retrieve their values
+    Counters stop();
+};
+
+// Measure the counters in the phases of the program from now on
+void enable();
+
+// Whether #enable has been invoked
+bool is_enabled();
+
+// Name of the event, for the log
+const char* to_string(Event event);
+
+} // namespace perf
@@ -0,0 +1,262 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "planner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <string>
+#include <unistd.h>
+
+#include "bitmap.hpp"
+#include "concurrent_set.hpp"
+#include "lib/common/error.hpp"
+
+using namespace std;
+
+/*****************************************************************************
+ *                                                                           *
+ *  Cost model                                                               *
+ *                                                                           *
+ *****************************************************************************/
+
+// Costs, in nanosecs, of a single thread
+constexpr double COST_RNG = 15; // draw a candidate edge, two random numbers
+constexpr double COST_ACCESS_CACHE = 5; // random access to a table that fits in the last level cache
+constexpr double COST_ACCESS_DRAM = 60; // random access to a table in main memory
+constexpr double COST_HASHSET = 150; // node allocation & chaining of std::unordered_set, single threaded
+constexpr double COST_CUCKOO = 100; // bucket locks & displacements of libcuckoo
+constexpr double COST_SHARDED = 40; // routing the candidate to the owner of its shard
+constexpr double COST_SAMPLING = 45; // split the ranges, draw an edge in a leaf and put it in order
+constexpr double COST_SORT = 40; // sort an edge
+constexpr double COST_SCAN_BYTE = 0.4; // scan a byte of a bitmap or a table, to extract the edges
+constexpr double COST_FORMAT = 40; // format and checksum a line of the output files, single threaded
+constexpr double PARALLEL_EFFICIENCY = 0.8; // fraction of the ideal speed up achieved with multiple threads
+constexpr uint64_t LLC_SIZE = 32ull << 20; // size of the last level cache, in bytes
+
+const char* to_string(DedupBackend backend){
+    switch(backend){
+    case DedupBackend::AUTO: return "auto";
+    case DedupBackend::HASHSET: return "hashset";
+    case DedupBackend::BITMAP: return "bitmap";
+    case DedupBackend::LOCKFREE: return "lockfree";
+    case DedupBackend::CUCKOO: return "cuckoo";
+    case DedupBackend::SHARDED: return "sharded";
+    case DedupBackend::SAMPLING: return "sampling";
+    default: return "unknown";
+    }
+}
+
+uint64_t max_num_edges(uint64_t num_vertices, bool directed){
+    if(num_vertices < 2) return 0;
+    unsigned __int128 result = (unsigned __int128) num_vertices * (num_vertices -1) / (directed ? 1 : 2);
+    return (result > numeric_limits<uint64_t>::max()) ? numeric_limits<uint64_t>::max() : static_cast<uint64_t>(result);
+}
+
+static uint64_t next_power_of_two(uint64_t value){
+    uint64_t result = 64;
+    while(result < value){ result *= 2; }
+    return result;
+}
+
+// Expected number of draws to collect num_edges distinct edges out of max_edges, without self loops:
+// max_edges * (H(max_edges) - H(max_edges - num_edges)), with H the harmonic numbers
+static double expected_draws(double max_edges, double num_edges){
+    if(num_edges <= 0) return 0;
+    return max_edges * log((max_edges + 0.5) / (max_edges - num_edges + 0.5));
+}
+
+static uint64_t physical_memory(){
+    return static_cast<uint64_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+}
+
+// Time, in seconds, of `num_operations' operations that cost `cost' nanosecs each, split among `num_threads' threads
+static double parallel_time(double num_operations, double cost, int num_threads){
+    double speedup = (num_threads <= 1) ? 1.0 : num_threads * PARALLEL_EFFICIENCY;
+    return num_operations * cost / speedup / 1e9;
+}
+
+static double access_cost(uint64_t table_size){
+    return (table_size <= LLC_SIZE) ? COST_ACCESS_CACHE : COST_ACCESS_DRAM;
+}
+
+static PlanCandidate estimate(const Plan& plan, DedupBackend backend){
+    const uint64_t V = plan.m_num_vertices;
+    const uint64_t E = plan.m_num_edges;
+    const int T = plan.m_num_threads;
+    const double C = plan.m_num_candidates;
+    const uint64_t edges_size = E * sizeof(Edge); // the final list of edges
+    const uint64_t vertices_size = V * sizeof(uint64_t);
+
+    PlanCandidate candidate;
+    candidate.m_backend = backend;
+    switch(backend){
+    case DedupBackend::HASHSET: {
+        uint64_t table_size = E * 48; // node (next, edge, hash) + bucket
+        candidate.m_memory = table_size + edges_size;
+        candidate.m_generate_time = parallel_time(C, COST_RNG + COST_HASHSET + 2 * access_cost(table_size), 1);
+    } break;
+    case DedupBackend::BITMAP: {
+        uint64_t table_size = AdjacencyBitmap::memory_footprint(V, plan.m_directed);
+        candidate.m_sorted = true;
+        candidate.m_memory = (table_size == numeric_limits<uint64_t>::max()) ? table_size : table_size + edges_size;
+        if(V > (1ull<<32)){
+            candidate.m_feasible = false; candidate.m_reason = "too many vertices";
+        } else if(table_size > plan.m_memory_budget){
+            candidate.m_feasible = false; candidate.m_reason = "exceeds the memory budget";
+        }
+        candidate.m_generate_time = parallel_time(C, COST_RNG + access_cost(table_size), T) + parallel_time(table_size, COST_SCAN_BYTE, T);
+    } break;
+    case DedupBackend::LOCKFREE: {
+        uint64_t table_size = ConcurrentEdgeSet::memory_footprint(E);
+        candidate.m_memory = table_size + edges_size;
+        candidate.m_generate_time = parallel_time(C, COST_RNG + access_cost(table_size), T) + parallel_time(table_size, COST_SCAN_BYTE, T);
+    } break;
+    case DedupBackend::CUCKOO: {
+        uint64_t table_size = next_power_of_two(E + E / 8) * 16; // 16 bytes per slot, the table doubles when full
+        candidate.m_memory = table_size + edges_size;
+        candidate.m_generate_time = parallel_time(C, COST_RNG + COST_CUCKOO + 2 * access_cost(table_size), T) + parallel_time(table_size, COST_SCAN_BYTE, T);
+    } break;
+    case DedupBackend::SHARDED: {
+        // the shards hold exactly E edges, E / 8 covers the imbalance among them
+        uint64_t table_size = next_power_of_two(2 * (E + E / 8)) * sizeof(uint64_t); // the hash sets of all shards
+        uint64_t shard_table_size = table_size / max(1, T);
+        candidate.m_sorted = true;
+        candidate.m_memory = table_size + (E + E / 8) * sizeof(Edge) /* edges of the shards */ + edges_size;
+        candidate.m_generate_time = parallel_time(C, COST_RNG + COST_SHARDED + access_cost(shard_table_size), T) + parallel_time(E, COST_SORT, T);
+    } break;
+    case DedupBackend::SAMPLING: {
+        candidate.m_sorted = true;
+        candidate.m_memory = edges_size + E * sizeof(uint64_t) / 16 /* edge numbers of the tasks in progress */;
+        if(V > (1ull<<32)){ candidate.m_feasible = false; candidate.m_reason = "too many vertices"; }
+        candidate.m_generate_time = parallel_time(E, COST_SAMPLING, T);
+    } break;
+    default:
+        ERROR("Invalid backend: " << to_string(backend));
+    }
+
+    if((V > ConcurrentEdgeSet::MAX_NUM_VERTICES) && (backend == DedupBackend::LOCKFREE || backend == DedupBackend::CUCKOO || backend == DedupBackend::SHARDED)){
+        candidate.m_feasible = false; candidate.m_reason = "too many vertices";
+    }
+    if(candidate.m_feasible && candidate.m_memory + vertices_size > plan.m_physical_memory){
+        candidate.m_feasible = false; candidate.m_reason = "exceeds the physical memory";
+    }
+    if(candidate.m_memory != numeric_limits<uint64_t>::max()){ candidate.m_memory += vertices_size; }
+
+    if(!candidate.m_sorted){
+        candidate.m_sort_time = parallel_time(E, COST_SORT, T);
+    }
+    candidate.m_save_time = parallel_time(E + V, COST_FORMAT, 1);
+
+    return candidate;
+}
+
+Plan make_plan(uint64_t num_vertices, uint64_t num_edges, int num_threads, uint64_t memory_budget, DedupBackend requested, bool directed){
+    Plan plan;
+    plan.m_num_vertices = num_vertices;
+    plan.m_num_edges = num_edges;
+    plan.m_directed = directed;
+    plan.m_num_threads = max(1, num_threads);
+    plan.m_memory_budget = memory_budget;
+    plan.m_physical_memory = physical_memory();
+    const double max_edges = static_cast<double>(max_num_edges(num_vertices, directed));
+    plan.m_density = (max_edges > 0) ? num_edges / max_edges : 0;
+    plan.m_num_candidates = expected_draws(max_edges, num_edges) * num_vertices / max<double>(1, num_vertices -1) /* self loops */;
+
+    for(auto backend : { DedupBackend::HASHSET, DedupBackend::BITMAP, DedupBackend::LOCKFREE, DedupBackend::CUCKOO, DedupBackend::SHARDED, DedupBackend::SAMPLING }){
+        plan.m_candidates.push_back(estimate(plan, backend));
+    }
+
+    if(requested != DedupBackend::AUTO){
+        plan.m_forced = true;
+        plan.m_backend = requested;
+    } else {
+        const PlanCandidate* best = nullptr;
+        for(auto& candidate : plan.m_candidates){
+            if(candidate.m_feasible && (best == nullptr || candidate.total_time() < best->total_time())){ best = &candidate; }
+        }
+        // nothing fits in memory, fall back to the backend with the smallest footprint and hope for the swap
+        if(best == nullptr){
+            for(auto& candidate : plan.m_candidates){
+                if(candidate.m_backend != DedupBackend::BITMAP && (best == nullptr || candidate.m_memory < best->m_memory)){ best = &candidate; }
+            }
+        }
+        plan.m_backend = best->m_backend;
+    }
+
+    return plan;
+}
+
+const PlanCandidate& Plan::selected() const {
+    for(auto& candidate : m_candidates){
+        if(candidate.m_backend == m_backend) return candidate;
+    }
+    ERROR("Backend not considered by the plan: " << to_string(m_backend));
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Print                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+static string format_bytes(uint64_t bytes){
+    if(bytes == numeric_limits<uint64_t>::max()) return "-";
+    static const char* units[] = { "B", "KB", "MB", "GB", "TB", "PB" };
+    double value = bytes;
+    int unit = 0;
+    while(value >= 1024 && unit < 5){ value /= 1024; unit++; }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), (unit == 0) ? "%.0f %s" : "%.2f %s", value, units[unit]);
+    return buffer;
+}
+
+static string format_seconds(double seconds){
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.2f s", seconds);
+    return buffer;
+}
+
+void print_plan(ostream& out, const Plan& plan){
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "Plan, density: %.3g, expected candidate edges: %.0f, threads: %d", plan.m_density, plan.m_num_candidates, plan.m_num_threads);
+    out << buffer << ", memory budget for the bitmap: " << format_bytes(plan.m_memory_budget) << ", physical memory: " << format_bytes(plan.m_physical_memory) << "\n";
+
+    auto print_row = [&](const string& backend, const string& memory, const string& generate, const string& sort, const string& save, const string& total, const string& notes){
+        out << "  " << left << setw(10) << backend << right << "  " << setw(10) << memory << "  " << setw(10) << generate << "  " << setw(10) << sort
+            << "  " << setw(10) << save << "  " << setw(10) << total << (notes.empty() ? "" : "  ") << notes << "\n";
+    };
+    print_row("Backend", "Memory", "Generate", "Sort", "Format", "Total", "");
+    for(auto& candidate : plan.m_candidates){
+        string notes;
+        if(!candidate.m_feasible){ notes = candidate.m_reason; }
+        if(candidate.m_backend == plan.m_backend){
+            if(!notes.empty()) notes += ", ";
+            notes += plan.m_forced ? "<= requested by --dedup" : "<= selected";
+        }
+        print_row(to_string(candidate.m_backend), format_bytes(candidate.m_memory), format_seconds(candidate.m_generate_time),
+                candidate.m_sorted ? string("-") : format_seconds(candidate.m_sort_time), format_seconds(candidate.m_save_time),
+                format_seconds(candidate.total_time()), notes);
+    }
+
+    const PlanCandidate& selected = plan.selected();
+    out << "Estimated time: " << format_seconds(selected.total_time()) << " (excluding the storage), estimated peak memory: " << format_bytes(selected.m_memory) << "\n";
+    out.flush();
+}
@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// The data structure used to discard the duplicate edges, or SAMPLING to draw the edges without replacement
+enum class DedupBackend { AUTO, HASHSET, BITMAP, LOCKFREE, CUCKOO, SHARDED, SAMPLING };
+
+// String representation of the backend
+const char* to_string(DedupBackend backend);
+
+/**
+ * The estimated cost of generating a graph with a given dedup backend
+ */
+struct PlanCandidate {
+    DedupBackend m_backend; // the dedup backend
+    bool m_feasible = true; // whether the backend can be used for the graph
+    const char* m_reason = ""; // why the backend is not feasible
+    bool m_sorted = false; // whether the backend already produces the edges sorted
+    uint64_t m_memory = 0; // estimated peak memory, in bytes, of the whole run
+    double m_generate_time = 0; // estimated time to generate the edges, in seconds
+    double m_sort_time = 0; // estimated time to sort the edges, in seconds
+    double m_save_time = 0; // estimated time to format the vertices and the edges, in seconds, excluding the storage
+
+    // The estimated time of the whole run, in seconds
+    double total_time() const { return m_generate_time + m_sort_time + m_save_time; }
+};
+
+/**
+ * The backend chosen to generate a graph, together with the estimates of all backends considered
+ */
+struct Plan {
+    uint64_t m_num_vertices = 0; // number of vertices in the graph
+    uint64_t m_num_edges = 0; // number of edges in the graph
+    bool m_directed = false; // whether the graph is directed
+    int m_num_threads = 0; // number of threads to generate the edges
+    uint64_t m_memory_budget = 0; // max amount of memory for the adjacency bitmap
+    uint64_t m_physical_memory = 0; // the total memory of the machine
+    double m_density = 0; // E / max_num_edges(V)
+    double m_num_candidates = 0; // expected number of candidate edges drawn, including self loops and duplicates
+    bool m_forced = false; // whether the backend was chosen by the user rather than by the planner
+    DedupBackend m_backend = DedupBackend::AUTO; // the backend to use
+    std::vector<PlanCandidate> m_candidates; // all backends considered
+
+    // The estimates of the chosen backend
+    const PlanCandidate& selected() const;
+};
+
+/**
+ * Choose the dedup backend for a graph with the given vertices and edges. The planner estimates the peak memory
+ * and the time of each backend with a simple cost model, based on the density of the graph, the number of
+ * candidate edges to draw, whether the dedup table fits in the last level cache and the number of threads.
+ * Among the backends that fit in the memory, it selects the fastest. The adjacency bitmap is also subject to
+ * `memory_budget'. If `requested' is not DedupBackend::AUTO, that backend is used regardless of the estimates.
+ * The constants of the model are rough figures of a commodity server: the estimates are meant to rank the
+ * backends, not to predict the exact run time.
+ */
+Plan make_plan(uint64_t num_vertices, uint64_t num_edges, int num_threads, uint64_t memory_budget, DedupBackend requested = DedupBackend::AUTO, bool directed = false);
+
+// Print the plan as a table
+void print_plan(std::ostream& out, const Plan& plan);
+
+// The max number of edges in a graph with the given vertices, V * (V -1) / 2, or V * (V -1) if the graph is directed,
+// saturated to 2^64 -1
+uint64_t max_num_edges(uint64_t num_vertices, bool directed = false);
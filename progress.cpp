@@ -0,0 +1,177 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "progress.hpp"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <signal.h>
+#include <thread>
+
+#include "lib/common/error.hpp"
+
+using namespace std;
+
+namespace progress {
+
+static unique_ptr<Counters[]> g_counters; // one for each worker thread
+static int g_num_counters = 0; // number of entries in g_counters
+static uint64_t g_num_edges = 0; // the total number of edges to generate
+static thread g_thread; // the background thread
+static atomic<bool> g_stop = false; // signal the background thread to terminate
+static mutex g_mutex; // protect the current phase and the printing
+static string g_phase; // name of the current phase
+static chrono::steady_clock::time_point g_start; // when the background thread started
+static chrono::steady_clock::time_point g_phase_start; // when the current phase started
+static uint64_t g_phase_edges_accepted = 0; // edges accepted when the current phase started
+static uint64_t g_phase_bytes_written = 0; // bytes written when the current phase started
+
+void init(int num_threads, uint64_t num_edges){
+    g_num_counters = max(1, num_threads);
+    g_counters.reset(new Counters[g_num_counters]);
+    g_num_edges = num_edges;
+    g_start = g_phase_start = chrono::steady_clock::now();
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    int rc = pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    if(rc != 0){ ERROR("pthread_sigmask: " << rc); }
+}
+
+Counters& counters(int thread_id){
+    if(thread_id >= 0 && thread_id < g_num_counters){
+        return g_counters[thread_id];
+    } else {
+        static thread_local Counters dummy;
+        return dummy;
+    }
+}
+
+static uint64_t sum(atomic<uint64_t> Counters::* counter){
+    uint64_t result = 0;
+    for(int i = 0; i < g_num_counters; i++){ result += (g_counters[i].*counter).load(memory_order_relaxed); }
+    return result;
+}
+
+static string format_seconds(double seconds){
+    char buffer[32];
+    uint64_t s = static_cast<uint64_t>(seconds);
+    snprintf(buffer, sizeof(buffer), "%02" PRIu64 ":%02" PRIu64 ":%02" PRIu64, s / 3600, (s / 60) % 60, s % 60);
+    return buffer;
+}
+
+void set_phase(const string& name){
+    lock_guard<mutex> lock(g_mutex);
+    g_phase = name;
+    g_phase_start = chrono::steady_clock::now();
+    g_phase_edges_accepted = (g_counters != nullptr) ? sum(&Counters::m_edges_accepted) : 0;
+    g_phase_bytes_written = (g_counters != nullptr) ? sum(&Counters::m_bytes_written) : 0;
+}
+
+void print(){
+    if(g_counters == nullptr) return;
+    lock_guard<mutex> lock(g_mutex);
+
+    auto now = chrono::steady_clock::now();
+    double elapsed = chrono::duration<double>(now - g_start).count();
+    double phase_elapsed = chrono::duration<double>(now - g_phase_start).count();
+    uint64_t edges_accepted = sum(&Counters::m_edges_accepted);
+    uint64_t duplicates = sum(&Counters::m_duplicates);
+    uint64_t self_loops = sum(&Counters::m_self_loops);
+    uint64_t bytes_written = sum(&Counters::m_bytes_written);
+
+    char buffer[512];
+    int length = snprintf(buffer, sizeof(buffer), "[progress %s] %s, edges: %" PRIu64 "/%" PRIu64 " (%.1f%%), duplicates: %" PRIu64 ", self loops: %" PRIu64 ", written: %.1f MB",
+            format_seconds(elapsed).c_str(), g_phase.empty() ? "-" : g_phase.c_str(), edges_accepted, g_num_edges,
+            g_num_edges > 0 ? 100.0 * edges_accepted / g_num_edges : 0.0, duplicates, self_loops, bytes_written / 1048576.0);
+
+    // rate & ETA of the edges accepted in this phase
+    uint64_t phase_edges = edges_accepted - g_phase_edges_accepted;
+    if(phase_edges > 0 && edges_accepted < g_num_edges && phase_elapsed > 0 && length < static_cast<int>(sizeof(buffer))){
+        double rate = phase_edges / phase_elapsed;
+        length += snprintf(buffer + length, sizeof(buffer) - length, ", rate: %.2f M edges/s, ETA: %s", rate / 1e6, format_seconds((g_num_edges - edges_accepted) / rate).c_str());
+    }
+
+    // rate of the bytes written in this phase
+    uint64_t phase_bytes = bytes_written - g_phase_bytes_written;
+    if(phase_bytes > 0 && phase_elapsed > 0 && length < static_cast<int>(sizeof(buffer))){
+        snprintf(buffer + length, sizeof(buffer) - length, ", rate: %.1f MB/s", phase_bytes / phase_elapsed / 1048576.0);
+    }
+
+    cout << buffer << endl;
+}
+
+Totals totals(){
+    Totals result;
+    if(g_counters == nullptr) return result;
+    result.m_edges_accepted = sum(&Counters::m_edges_accepted);
+    result.m_duplicates = sum(&Counters::m_duplicates);
+    result.m_self_loops = sum(&Counters::m_self_loops);
+    result.m_bytes_written = sum(&Counters::m_bytes_written);
+    return result;
+}
+
+static void run(double interval_seconds){
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+
+    auto next_print = chrono::steady_clock::now() + chrono::duration<double>(interval_seconds);
+    while(!g_stop){
+        int rc;
+        if(interval_seconds > 0){
+            double timeout = max(0.0, chrono::duration<double>(next_print - chrono::steady_clock::now()).count());
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(timeout);
+            ts.tv_nsec = static_cast<long>((timeout - ts.tv_sec) * 1e9);
+            rc = sigtimedwait(&signals, nullptr, &ts);
+        } else {
+            rc = sigwaitinfo(&signals, nullptr);
+        }
+        if(g_stop) break;
+
+        if(rc == SIGUSR1){ // on demand
+            print();
+        } else if (interval_seconds > 0 && chrono::steady_clock::now() >= next_print){ // timeout
+            print();
+            next_print += chrono::duration<double>(interval_seconds);
+        } // else, interrupted by another signal
+    }
+}
+
+void start(double interval_seconds){
+    if(g_counters == nullptr){ ERROR("progress::init() not invoked"); }
+    if(g_thread.joinable()) return; // already started
+    g_stop = false;
+    g_start = chrono::steady_clock::now();
+    g_thread = thread(run, interval_seconds);
+}
+
+void stop(){
+    if(!g_thread.joinable()) return;
+    g_stop = true;
+    pthread_kill(g_thread.native_handle(), SIGUSR1); // wake up the thread
+    g_thread.join();
+}
+
+} // namespace progress
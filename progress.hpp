@@ -0,0 +1,76 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * Live progress of a run. The hot loops update a set of counters, one for each worker thread, padded to a
+ * cache line and only written by the thread owning them, so that updating a counter is a plain store. A
+ * background thread samples the counters and prints the rate and the ETA every given interval, or immediately
+ * when the process receives SIGUSR1.
+ */
+namespace progress {
+
+struct alignas(64) Counters {
+    std::atomic<uint64_t> m_edges_accepted {0}; // new edges inserted in the graph
+    std::atomic<uint64_t> m_duplicates {0}; // candidate edges rejected because already present
+    std::atomic<uint64_t> m_self_loops {0}; // candidate edges rejected because the source is equal to the destination
+    std::atomic<uint64_t> m_bytes_written {0}; // bytes written to the output files
+
+    // Increment the given counter. Only the thread owning the counters can invoke this method.
+    static void add(std::atomic<uint64_t>& counter, uint64_t value = 1) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+};
+
+// The sum of the counters of all threads
+struct Totals {
+    uint64_t m_edges_accepted = 0;
+    uint64_t m_duplicates = 0;
+    uint64_t m_self_loops = 0;
+    uint64_t m_bytes_written = 0;
+};
+
+// Allocate the counters for the given number of worker threads, with num_edges being the edges to generate.
+// It also blocks SIGUSR1 for the calling thread, and therefore for the threads it creates afterwards, so it must
+// be invoked by the main thread before any other thread is started.
+void init(int num_threads, uint64_t num_edges);
+
+// The counters of the given worker thread, 0 for the main thread. If the thread is out of range, return a
+// thread local instance that is not sampled.
+Counters& counters(int thread_id);
+
+// Start the background thread, printing the progress every `interval_seconds' (0 => only on SIGUSR1)
+void start(double interval_seconds);
+
+// Stop the background thread
+void stop();
+
+// Set the name of the current phase, as shown in the progress lines
+void set_phase(const std::string& name);
+
+// Print the current counters
+void print();
+
+// Retrieve the current counters, summed over all threads
+Totals totals();
+
+} // namespace progress
@@ -0,0 +1,350 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "report.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/resource.h>
+#include <utility>
+
+#include "lib/common/error.hpp"
+#include "numa.hpp"
+#include "progress.hpp"
+
+using namespace std;
+
+namespace report {
+
+static vector<PhaseStatistics> g_phases; // the phases completed so far
+static vector<pair<string, string>> g_parameters; // key, value already formatted in JSON
+static vector<pair<string, string>> g_statistics; // key, value already formatted in JSON
+
+static double wall_clock(){
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double cpu_clock(){
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t peak_rss(){
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // ru_maxrss is in KB
+}
+
+static double items_per_second(const PhaseStatistics& phase){
+    return (phase.m_wall_time > 0) ? phase.m_num_items / phase.m_wall_time : 0;
+}
+
+// Bytes per second moved by the threads of the given node over the whole phase
+static double node_bandwidth(const PhaseStatistics& phase, size_t node){
+    return (phase.m_wall_time > 0 && node < phase.m_bytes_per_node.size()) ? phase.m_bytes_per_node[node] / phase.m_wall_time : 0;
+}
+
+// Instructions per cycle, or a negative value if not available
+static double ipc(const perf::Counters& counters){
+    if(!counters.m_available[perf::CYCLES] || !counters.m_available[perf::INSTRUCTIONS] || counters.m_values[perf::CYCLES] == 0) return -1;
+    return static_cast<double>(counters.m_values[perf::INSTRUCTIONS]) / counters.m_values[perf::CYCLES];
+}
+
+// Number of events per item processed in the phase, or a negative value if not available
+static double events_per_item(const PhaseStatistics& phase, perf::Event event){
+    if(!phase.m_counters.m_available[event] || phase.m_num_items == 0) return -1;
+    return static_cast<double>(phase.m_counters.m_values[event]) / phase.m_num_items;
+}
+
+Phase::Phase(const string& name) : m_wall_start(wall_clock()), m_cpu_start(cpu_clock()) {
+    m_stats.m_name = name;
+    progress::set_phase(name);
+    if(trace::is_enabled()){
+        m_span.reset(new trace::Span(trace::intern(name)));
+    }
+    if(perf::is_enabled()){
+        m_counters.reset(new perf::CounterSet());
+        m_counters->start();
+    }
+}
+
+Phase::~Phase(){
+    stop();
+}
+
+void Phase::set_num_items(uint64_t num_items){
+    m_stats.m_num_items = num_items;
+}
+
+void Phase::add_bytes_written(uint64_t num_bytes){
+    m_stats.m_bytes_written += num_bytes;
+}
+
+void Phase::add_bytes_per_node(const vector<size_t>& bytes_per_node){
+    if(!numa::is_enabled()) return;
+    if(m_stats.m_bytes_per_node.size() < bytes_per_node.size()){ m_stats.m_bytes_per_node.resize(bytes_per_node.size()); }
+    for(size_t node = 0; node < bytes_per_node.size(); node++){ m_stats.m_bytes_per_node[node] += bytes_per_node[node]; }
+}
+
+void Phase::stop(){
+    if(m_stopped) return;
+    m_stopped = true;
+    if(m_counters){
+        m_stats.m_counters = m_counters->stop();
+        m_counters.reset();
+    }
+    m_span.reset();
+    m_stats.m_wall_time = wall_clock() - m_wall_start;
+    m_stats.m_cpu_time = cpu_clock() - m_cpu_start;
+    m_stats.m_peak_rss = peak_rss();
+    g_phases.push_back(m_stats);
+}
+
+const vector<PhaseStatistics>& phases(){
+    return g_phases;
+}
+
+// The overall statistics of the run, the items processed are not comparable among phases and are left to 0
+static PhaseStatistics compute_total(){
+    PhaseStatistics total;
+    total.m_name = "Total";
+    for(auto& phase : g_phases){
+        total.m_wall_time += phase.m_wall_time;
+        total.m_cpu_time += phase.m_cpu_time;
+        total.m_bytes_written += phase.m_bytes_written;
+        total.m_peak_rss = max(total.m_peak_rss, phase.m_peak_rss);
+    }
+    return total;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Summary table                                                            *
+ *                                                                           *
+ *****************************************************************************/
+
+static string format_bytes(uint64_t bytes){
+    static const char* units[] = { "B", "KB", "MB", "GB", "TB" };
+    double value = bytes;
+    int unit = 0;
+    while(value >= 1024 && unit < 4){ value /= 1024; unit++; }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), (unit == 0) ? "%.0f %s" : "%.2f %s", value, units[unit]);
+    return buffer;
+}
+
+static string format_rate(double value){
+    char buffer[32];
+    if(value >= 1e9){
+        snprintf(buffer, sizeof(buffer), "%.2f G/s", value / 1e9);
+    } else if(value >= 1e6){
+        snprintf(buffer, sizeof(buffer), "%.2f M/s", value / 1e6);
+    } else if(value >= 1e3){
+        snprintf(buffer, sizeof(buffer), "%.2f K/s", value / 1e3);
+    } else {
+        snprintf(buffer, sizeof(buffer), "%.0f /s", value);
+    }
+    return buffer;
+}
+
+void print_summary(ostream& out){
+    if(g_phases.empty()) return;
+
+    size_t name_width = 5; // "Total"
+    for(auto& phase : g_phases){ name_width = max(name_width, phase.m_name.length()); }
+
+    auto print_row = [&](const string& name, const string& wall, const string& cpu, const string& items, const string& rate, const string& bytes, const string& rss){
+        out << left << setw(name_width) << name << right
+            << "  " << setw(10) << wall << "  " << setw(10) << cpu << "  " << setw(12) << items << "  " << setw(12) << rate
+            << "  " << setw(12) << bytes << "  " << setw(12) << rss << "\n";
+    };
+    auto fmt_seconds = [](double seconds){
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.3f s", seconds);
+        return string(buffer);
+    };
+
+    print_row("Phase", "Wall time", "CPU time", "Items", "Throughput", "Written", "Peak RSS");
+    for(auto& phase : g_phases){
+        print_row(phase.m_name, fmt_seconds(phase.m_wall_time), fmt_seconds(phase.m_cpu_time),
+                phase.m_num_items > 0 ? to_string(phase.m_num_items) : "-",
+                phase.m_num_items > 0 ? format_rate(items_per_second(phase)) : "-",
+                phase.m_bytes_written > 0 ? format_bytes(phase.m_bytes_written) : "-",
+                format_bytes(phase.m_peak_rss));
+    }
+    PhaseStatistics total = compute_total();
+    print_row("Total", fmt_seconds(total.m_wall_time), fmt_seconds(total.m_cpu_time), "-", "-",
+            total.m_bytes_written > 0 ? format_bytes(total.m_bytes_written) : "-", format_bytes(total.m_peak_rss));
+
+    if(perf::is_enabled()){
+        auto fmt_count = [](const perf::Counters& counters, perf::Event event){
+            return counters.m_available[event] ? to_string(counters.m_values[event]) : string("n/a");
+        };
+        auto fmt_ratio = [](double value){
+            if(value < 0) return string("-");
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.3f", value);
+            return string(buffer);
+        };
+
+        out << "\n" << left << setw(name_width) << "Phase" << right << "  " << setw(16) << "Cycles" << "  " << setw(16) << "Instructions"
+            << "  " << setw(6) << "IPC" << "  " << setw(14) << "LLC miss/item" << "  " << setw(14) << "dTLB miss/item" << "  " << setw(14) << "Br miss/item" << "\n";
+        for(auto& phase : g_phases){
+            out << left << setw(name_width) << phase.m_name << right << "  " << setw(16) << fmt_count(phase.m_counters, perf::CYCLES)
+                << "  " << setw(16) << fmt_count(phase.m_counters, perf::INSTRUCTIONS) << "  " << setw(6) << fmt_ratio(ipc(phase.m_counters))
+                << "  " << setw(14) << fmt_ratio(events_per_item(phase, perf::LLC_MISSES))
+                << "  " << setw(14) << fmt_ratio(events_per_item(phase, perf::DTLB_MISSES))
+                << "  " << setw(14) << fmt_ratio(events_per_item(phase, perf::BRANCH_MISSES)) << "\n";
+        }
+    }
+
+    size_t num_nodes = 0;
+    for(auto& phase : g_phases){ num_nodes = max(num_nodes, phase.m_bytes_per_node.size()); }
+    if(num_nodes > 0){
+        out << "\n" << left << setw(name_width) << "Phase" << right;
+        for(size_t node = 0; node < num_nodes; node++){ out << "  " << setw(14) << ("Node " + to_string(numa::node_id(node))); }
+        out << "\n";
+        for(auto& phase : g_phases){
+            if(phase.m_bytes_per_node.empty()) continue;
+            out << left << setw(name_width) << phase.m_name << right;
+            for(size_t node = 0; node < num_nodes; node++){
+                out << "  " << setw(14) << (node_bandwidth(phase, node) > 0 ? format_bytes(node_bandwidth(phase, node)) + "/s" : string("-"));
+            }
+            out << "\n";
+        }
+    }
+
+    out.flush();
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  JSON                                                                     *
+ *                                                                           *
+ *****************************************************************************/
+
+static string json_string(const string& value){
+    string result = "\"";
+    for(char c : value){
+        switch(c){
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if(static_cast<unsigned char>(c) < 0x20){
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                result += buffer;
+            } else {
+                result += c;
+            }
+        }
+    }
+    result += "\"";
+    return result;
+}
+
+static string json_number(double value){
+    ostringstream out;
+    out << setprecision(9) << value;
+    return out.str();
+}
+
+static void set_json(vector<pair<string, string>>& section, const string& key, const string& json_value){
+    for(auto& p : section){
+        if(p.first == key){ p.second = json_value; return; }
+    }
+    section.emplace_back(key, json_value);
+}
+
+void set_parameter(const string& key, const string& value){ set_json(g_parameters, key, json_string(value)); }
+void set_parameter(const string& key, const char* value){ set_json(g_parameters, key, json_string(value)); }
+void set_parameter(const string& key, uint64_t value){ set_json(g_parameters, key, to_string(value)); }
+void set_parameter(const string& key, int value){ set_json(g_parameters, key, to_string(value)); }
+void set_parameter(const string& key, double value){ set_json(g_parameters, key, json_number(value)); }
+void set_parameter(const string& key, bool value){ set_json(g_parameters, key, value ? "true" : "false"); }
+void set_statistic(const string& key, uint64_t value){ set_json(g_statistics, key, to_string(value)); }
+void set_statistic(const string& key, double value){ set_json(g_statistics, key, json_number(value)); }
+
+static void save_section(fstream& out, const char* name, const vector<pair<string, string>>& section){
+    out << "  " << json_string(name) << ": {";
+    for(size_t i = 0; i < section.size(); i++){
+        out << (i == 0 ? "\n" : ",\n") << "    " << json_string(section[i].first) << ": " << section[i].second;
+    }
+    out << "\n  },\n";
+}
+
+void save_json(const string& path){
+    fstream out { path, ios::out };
+    if(!out.good()) ERROR("Cannot create the file `" << path << "'");
+
+    out << "{\n";
+    save_section(out, "parameters", g_parameters);
+    save_section(out, "statistics", g_statistics);
+
+    out << "  \"phases\": [";
+    for(size_t i = 0; i < g_phases.size(); i++){
+        const PhaseStatistics& phase = g_phases[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    { \"name\": " << json_string(phase.m_name) << ", \"wall_time\": " << json_number(phase.m_wall_time)
+            << ", \"cpu_time\": " << json_number(phase.m_cpu_time) << ", \"items\": " << phase.m_num_items
+            << ", \"items_per_second\": " << json_number(items_per_second(phase)) << ", \"bytes_written\": " << phase.m_bytes_written
+            << ", \"peak_rss\": " << phase.m_peak_rss;
+        if(perf::is_enabled()){
+            auto json_ratio = [](double value){ return value < 0 ? string("null") : json_number(value); };
+            out << ", \"perf_counters\": { ";
+            for(int e = 0; e < perf::NUM_EVENTS; e++){
+                out << json_string(perf::to_string(static_cast<perf::Event>(e))) << ": ";
+                if(phase.m_counters.m_available[e]){ out << phase.m_counters.m_values[e]; } else { out << "null"; }
+                out << ", ";
+            }
+            out << "\"ipc\": " << json_ratio(ipc(phase.m_counters));
+            for(perf::Event e : { perf::LLC_MISSES, perf::DTLB_MISSES, perf::BRANCH_MISSES }){
+                out << ", " << json_string(string(perf::to_string(e)) + "_per_item") << ": " << json_ratio(events_per_item(phase, e));
+            }
+            out << " }";
+        }
+        if(!phase.m_bytes_per_node.empty()){
+            out << ", \"numa_nodes\": [";
+            for(size_t node = 0; node < phase.m_bytes_per_node.size(); node++){
+                out << (node == 0 ? " " : ", ") << "{ \"node\": " << numa::node_id(node) << ", \"bytes\": " << phase.m_bytes_per_node[node]
+                    << ", \"bytes_per_second\": " << json_number(node_bandwidth(phase, node)) << " }";
+            }
+            out << " ]";
+        }
+        out << " }";
+    }
+    out << "\n  ],\n";
+
+    PhaseStatistics total = compute_total();
+
+    out << "  \"total\": { \"wall_time\": " << json_number(total.m_wall_time) << ", \"cpu_time\": " << json_number(total.m_cpu_time)
+        << ", \"bytes_written\": " << total.m_bytes_written << ", \"peak_rss\": " << total.m_peak_rss << " }\n";
+    out << "}\n";
+
+    out.close();
+    if(out.fail()) ERROR("Cannot write the file `" << path << "'");
+}
+
+} // namespace report
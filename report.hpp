@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "perf.hpp"
+#include "trace.hpp"
+
+/**
+ * Instrumentation of the phases of a run: generating the edges, sorting them, creating the vertices and saving
+ * the files. Each phase records its wall time, the CPU time of the whole process (summed over all threads),
+ * the number of items processed, the bytes written and the peak resident set size observed at its end.
+ * If perf::is_enabled(), each phase also reads the hardware performance counters. The results can be printed as
+ * a table or saved in a JSON file, together with the parameters of the run. If trace::is_enabled(), each phase is
+ * also recorded as a span of the main thread. If numa::is_enabled(), the phases with multiple threads also record
+ * the bytes moved by the threads of each NUMA node, reported as the bandwidth achieved by each node.
+ */
+namespace report {
+
+struct PhaseStatistics {
+    std::string m_name; // name of the phase
+    double m_wall_time = 0; // elapsed time, in seconds
+    double m_cpu_time = 0; // user + system time of the process, in seconds
+    uint64_t m_num_items = 0; // number of edges or vertices processed
+    uint64_t m_bytes_written = 0; // bytes written to the output files
+    uint64_t m_peak_rss = 0; // max resident set size of the process, in bytes, at the end of the phase
+    perf::Counters m_counters; // hardware performance counters, only if perf::is_enabled()
+    std::vector<uint64_t> m_bytes_per_node; // bytes read & written by the threads of each NUMA node, empty if not measured
+};
+
+/**
+ * Record a phase, from its construction until #stop is invoked or the instance goes out of scope
+ */
+class Phase {
+    PhaseStatistics m_stats;
+    double m_wall_start; // wall clock at the start of the phase, in seconds
+    double m_cpu_start; // cpu time at the start of the phase, in seconds
+    std::unique_ptr<perf::CounterSet> m_counters; // nullptr if the perf counters are not enabled
+    std::unique_ptr<trace::Span> m_span; // the phase in the trace, nullptr if tracing is not enabled
+    bool m_stopped = false;
+
+public:
+    // Start a new phase
+    Phase(const std::string& name);
+
+    // Stop the phase, if not already done
+    ~Phase();
+
+    Phase(const Phase&) = delete;
+    Phase& operator=(const Phase&) = delete;
+
+    // Set the number of items processed in the phase
+    void set_num_items(uint64_t num_items);
+
+    // Add the given amount of bytes to the total written in the phase
+    void add_bytes_written(uint64_t num_bytes);
+
+    // Add the bytes read & written by the threads of each NUMA node, indexed as numa::node_of_thread. Ignored if
+    // NUMA awareness is not enabled.
+    void add_bytes_per_node(const std::vector<size_t>& bytes_per_node);
+
+    // Stop the phase and record its statistics. Further invocations are ignored.
+    void stop();
+};
+
+// Record a parameter of the run, to be saved in the JSON report
+void set_parameter(const std::string& key, const std::string& value);
+void set_parameter(const std::string& key, const char* value);
+void set_parameter(const std::string& key, uint64_t value);
+void set_parameter(const std::string& key, int value);
+void set_parameter(const std::string& key, double value);
+void set_parameter(const std::string& key, bool value);
+
+// Record a statistic of the run, e.g. the number of duplicate edges, to be saved in the JSON report
+void set_statistic(const std::string& key, uint64_t value);
+void set_statistic(const std::string& key, double value);
+
+// The phases completed so far, in order
+const std::vector<PhaseStatistics>& phases();
+
+// Print the statistics of all phases completed as a table
+void print_summary(std::ostream& out);
+
+// Save the parameters and the statistics of all phases completed in the given file, in JSON format
+void save_json(const std::string& path);
+
+} // namespace report
@@ -0,0 +1,343 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "sampling.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+#include "lib/common/error.hpp"
+#include "generator.hpp"
+#include "progress.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t LEAF_EDGES = 1024; // max number of edges of a range sampled directly
+constexpr uint64_t LEAF_RANGE = 4096; // max size of a range sampled directly, regardless of its edges
+constexpr uint64_t TASKS_PER_THREAD = 16; // split the work in about this number of tasks per thread
+
+// A range of possible edges, [m_first, m_first + m_length), holding m_num_edges edges of the graph
+struct Range {
+    uint64_t m_first;
+    uint64_t m_length;
+    uint64_t m_num_edges;
+
+    uint64_t end() const { return m_first + m_length; }
+    bool is_leaf() const { return m_num_edges <= LEAF_EDGES || m_length <= LEAF_RANGE; }
+};
+
+/**
+ * The random stream of a range, splitmix64 seeded with the seed of the graph and the bounds of the range
+ */
+class RangeRandom {
+    uint64_t m_state;
+
+public:
+    RangeRandom(uint64_t seed, const Range& range) : m_state(hash_mix(seed ^ hash_mix(range.m_first * 0x9e3779b97f4a7c15ull ^ hash_mix(range.m_length)))) { }
+
+    uint64_t next(){
+        m_state += 0x9e3779b97f4a7c15ull;
+        return hash_mix(m_state);
+    }
+
+    // Uniform in [0, 1)
+    double uniform(){ return (next() >> 11) * 0x1.0p-53; }
+
+    // Uniform in [0, bound), Lemire's multiply & reject
+    uint64_t below(uint64_t bound){
+        unsigned __int128 product = (unsigned __int128) next() * bound;
+        uint64_t low = static_cast<uint64_t>(product);
+        if(low < bound){
+            uint64_t threshold = -bound % bound;
+            while(low < threshold){
+                product = (unsigned __int128) next() * bound;
+                low = static_cast<uint64_t>(product);
+            }
+        }
+        return product >> 64;
+    }
+};
+
+/**
+ * Number of items drawn among the first `num_successes' of `population' items, in a sample of `sample_size' items
+ * without replacement. The probabilities are computed relative to the mode, with the ratio of consecutive terms,
+ * and the tails below 1e-20 are discarded. The cost is linear in the standard deviation.
+ */
+uint64_t hypergeometric(uint64_t population, uint64_t num_successes, uint64_t sample_size, RangeRandom& random){
+    const uint64_t N = population, K = num_successes, n = sample_size;
+    if(n == 0 || K == 0) return 0;
+    if(K == N) return n;
+    if(n == N) return K;
+    const uint64_t low = (n > N - K) ? n - (N - K) : 0;
+    const uint64_t high = min(n, K);
+    uint64_t mode = static_cast<uint64_t>(floorl(((long double) n + 1) * ((long double) K + 1) / ((long double) N + 2)));
+    mode = max(low, min(high, mode));
+
+    // p(k +1) / p(k)
+    auto ratio = [&](uint64_t k) -> long double {
+        return ((long double) (K - k) * (long double) (n - k)) / ((long double) (k + 1) * (long double) ((N - K) - (n - k - 1)));
+    };
+    constexpr long double EPSILON = 1e-20L;
+
+    // the probabilities are relative to p(mode) = 1
+    long double total = 1;
+    long double p = 1;
+    for(uint64_t k = mode; k < high && (p *= ratio(k)) >= EPSILON; k++){ total += p; }
+    p = 1;
+    for(uint64_t k = mode; k > low && (p /= ratio(k -1)) >= EPSILON; k--){ total += p; }
+
+    // walk the same terms, in the same order
+    long double u = random.uniform() * total - 1;
+    if(u < 0) return mode;
+    p = 1;
+    for(uint64_t k = mode; k < high && (p *= ratio(k)) >= EPSILON; k++){
+        u -= p;
+        if(u < 0) return k +1;
+    }
+    p = 1;
+    for(uint64_t k = mode; k > low && (p /= ratio(k -1)) >= EPSILON; k--){
+        u -= p;
+        if(u < 0) return k -1;
+    }
+    return mode; // rounding errors
+}
+
+// Split the range in two halves
+pair<Range, Range> split(const Range& range, uint64_t seed){
+    RangeRandom random { seed, range };
+    uint64_t length_left = range.m_length / 2;
+    uint64_t edges_left = hypergeometric(range.m_length, length_left, range.m_num_edges, random);
+    return { Range{ range.m_first, length_left, edges_left }, Range{ range.m_first + length_left, range.m_length - length_left, range.m_num_edges - edges_left } };
+}
+
+/**
+ * Sample the edges of a leaf range, appending their numbers to the output in sorted order
+ */
+class LeafSampler {
+    // Floyd's algorithm, open addressing with linear probing & no wrap around, the edges drawn +1, 0 = empty slot.
+    // The hash function preserves the order, so that scanning the table yields the edges almost sorted.
+    vector<uint64_t> m_table;
+
+public:
+    LeafSampler() : m_table(3 * LEAF_EDGES) { }
+
+    void sample(const Range& range, uint64_t seed, vector<uint64_t>& output){
+        RangeRandom random { seed, range };
+        const uint64_t m = range.m_num_edges, n = range.m_length;
+
+        if(m == n){ // all edges
+            for(uint64_t i = 0; i < n; i++){ output.push_back(range.m_first + i); }
+        } else if(4 * m >= n){ // dense, selection sampling
+            uint64_t num_selected = 0;
+            for(uint64_t i = 0; i < n && num_selected < m; i++){
+                if(random.below(n - i) < m - num_selected){
+                    output.push_back(range.m_first + i);
+                    num_selected++;
+                }
+            }
+        } else { // sparse, Floyd's algorithm, m < n / 4 <= LEAF_EDGES
+            assert(m <= LEAF_EDGES);
+            const uint64_t num_slots = 2 * m; // a cluster can overflow by at most m slots
+            const uint64_t scale = ((unsigned __int128) num_slots << 64) / n; // slot = value * num_slots / n
+            fill(begin(m_table), begin(m_table) + num_slots + m, 0);
+            for(uint64_t j = n - m; j < n; j++){
+                uint64_t t = random.below(j +1);
+                if(!insert(t, scale)){ insert(j, scale); }
+            }
+
+            const size_t start = output.size();
+            for(uint64_t i = 0; i < num_slots + m; i++){
+                if(m_table[i] != 0){ output.push_back(range.m_first + m_table[i] -1); }
+            }
+            for(size_t i = start +1; i < output.size(); i++){ // insertion sort, the clusters are short
+                uint64_t value = output[i];
+                size_t j = i;
+                while(j > start && output[j -1] > value){ output[j] = output[j -1]; j--; }
+                output[j] = value;
+            }
+        }
+    }
+
+private:
+    // Return false if the value was already present
+    bool insert(uint64_t value, uint64_t scale){
+        uint64_t slot = ((unsigned __int128) value * scale) >> 64;
+        while(m_table[slot] != 0){
+            if(m_table[slot] == value +1) return false;
+            slot++;
+        }
+        m_table[slot] = value +1;
+        return true;
+    }
+};
+
+// Generate the edges of the range, in order
+void sample_range(const Range& range, uint64_t seed, LeafSampler& sampler, vector<uint64_t>& output){
+    if(range.m_num_edges == 0) return;
+    if(range.is_leaf()){
+        sampler.sample(range, seed, output);
+    } else {
+        auto halves = split(range, seed);
+        sample_range(halves.first, seed, sampler, output);
+        sample_range(halves.second, seed, sampler, output);
+    }
+}
+
+// Whether the range overlaps [first, last) only in part
+bool crosses(const Range& range, uint64_t first, uint64_t last){
+    return range.m_first < first || range.end() > last;
+}
+
+/**
+ * Split the ranges overlapping [first, last) until they are either leaves or fully inside [first, last), with at
+ * most `max_task_edges' edges. The ranges are appended in order.
+ */
+void collect_tasks(const Range& range, uint64_t seed, uint64_t first, uint64_t last, uint64_t max_task_edges, vector<Range>& tasks){
+    if(range.m_num_edges == 0 || range.end() <= first || range.m_first >= last) return;
+    if(range.is_leaf() || (!crosses(range, first, last) && range.m_num_edges <= max_task_edges)){
+        tasks.push_back(range);
+    } else {
+        auto halves = split(range, seed);
+        collect_tasks(halves.first, seed, first, last, max_task_edges, tasks);
+        collect_tasks(halves.second, seed, first, last, max_task_edges, tasks);
+    }
+}
+
+// Find the source of the given edge number, i.e. the last source such that count_edges_before(source) <= number
+uint64_t find_source(uint64_t number, uint64_t num_vertices, bool directed){
+    uint64_t low = 0, high = directed ? num_vertices : num_vertices -1; // in an undirected graph, the last source has no edges
+    while(high - low > 1){
+        uint64_t mid = low + (high - low) / 2;
+        if(count_edges_before(mid, num_vertices, directed) <= number){ low = mid; } else { high = mid; }
+    }
+    return low;
+}
+
+// Translate the edge numbers, in sorted order, into edges
+void decode(const uint64_t* numbers, uint64_t count, uint64_t num_vertices, bool directed, Edge* output){
+    if(count == 0) return;
+    uint64_t source = find_source(numbers[0], num_vertices, directed);
+    uint64_t source_start = count_edges_before(source, num_vertices, directed);
+    uint64_t source_end = count_edges_before(source +1, num_vertices, directed);
+    for(uint64_t i = 0; i < count; i++){
+        while(numbers[i] >= source_end){
+            source++;
+            source_start = source_end;
+            source_end = count_edges_before(source +1, num_vertices, directed);
+        }
+        output[i] = edge_at_position(source, numbers[i] - source_start, directed);
+    }
+}
+
+// The range of edge numbers of the given sources
+pair<uint64_t, uint64_t> to_numbers(uint64_t num_vertices, uint64_t first_source, uint64_t last_source, bool directed){
+    last_source = min(last_source, num_vertices);
+    first_source = min(first_source, last_source);
+    return { count_edges_before(first_source, num_vertices, directed), count_edges_before(last_source, num_vertices, directed) };
+}
+
+void check_arguments(uint64_t num_vertices, uint64_t num_edges, bool directed){
+    if(num_vertices > (1ull<<32)){ ERROR("Too many vertices for the sampling backend: " << num_vertices); }
+    if(num_edges > count_edges_before(num_vertices, num_vertices, directed)){ ERROR("Too many edges: " << num_edges); }
+}
+
+// Generate the edges of a leaf overlapping the boundaries of [first, last), retaining those inside
+vector<uint64_t> sample_boundary(const Range& range, uint64_t seed, uint64_t first, uint64_t last){
+    LeafSampler sampler;
+    vector<uint64_t> numbers;
+    sampler.sample(range, seed, numbers);
+    numbers.erase(remove_if(begin(numbers), end(numbers), [first, last](uint64_t number){ return number < first || number >= last; }), end(numbers));
+    return numbers;
+}
+
+} // anonymous namespace
+
+uint64_t count_edges_sampling(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, uint64_t first_source, uint64_t last_source, bool directed){
+    check_arguments(num_vertices, num_edges, directed);
+    auto numbers = to_numbers(num_vertices, first_source, last_source, directed);
+    vector<Range> tasks;
+    collect_tasks(Range{ 0, count_edges_before(num_vertices, num_vertices, directed), num_edges }, seed, numbers.first, numbers.second, numeric_limits<uint64_t>::max(), tasks);
+
+    uint64_t result = 0;
+    for(auto& task : tasks){
+        if(crosses(task, numbers.first, numbers.second)){
+            result += sample_boundary(task, seed, numbers.first, numbers.second).size();
+        } else {
+            result += task.m_num_edges;
+        }
+    }
+    return result;
+}
+
+edge_list_t make_edges_sampling(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, uint64_t first_source, uint64_t last_source, bool directed){
+    check_arguments(num_vertices, num_edges, directed);
+    if(num_threads < 1) num_threads = 1;
+    auto numbers = to_numbers(num_vertices, first_source, last_source, directed);
+    const Range root { 0, count_edges_before(num_vertices, num_vertices, directed), num_edges };
+
+    // the tasks, with the position of their edges in the output
+    vector<Range> tasks;
+    collect_tasks(root, seed, numbers.first, numbers.second, max(LEAF_EDGES, num_edges / (num_threads * TASKS_PER_THREAD)), tasks);
+    vector<vector<uint64_t>> boundaries(tasks.size()); // the edges of the leaves crossing [first, last), empty otherwise
+    vector<uint64_t> offsets(tasks.size() +1, 0);
+    for(size_t i = 0; i < tasks.size(); i++){
+        uint64_t count = tasks[i].m_num_edges;
+        if(crosses(tasks[i], numbers.first, numbers.second)){
+            boundaries[i] = sample_boundary(tasks[i], seed, numbers.first, numbers.second);
+            count = boundaries[i].size();
+        }
+        offsets[i +1] = offsets[i] + count;
+    }
+
+    edge_list_t edges(offsets.back());
+    atomic<size_t> next_task = 0;
+    mutex error_mutex; // an exception cannot leave a worker thread
+    exception_ptr error;
+    run_in_parallel(num_threads, [&](int thread_id){
+        LeafSampler sampler;
+        vector<uint64_t> output;
+        progress::Counters& counters = progress::counters(thread_id);
+        for(size_t i = next_task++; i < tasks.size(); i = next_task++){
+            try {
+                trace::Span span { "sample", tasks[i].m_first };
+                const vector<uint64_t>* task_numbers = &boundaries[i];
+                if(!crosses(tasks[i], numbers.first, numbers.second)){
+                    output.clear();
+                    sample_range(tasks[i], seed, sampler, output);
+                    task_numbers = &output;
+                }
+                assert(task_numbers->size() == offsets[i +1] - offsets[i]);
+                decode(task_numbers->data(), task_numbers->size(), num_vertices, directed, edges.data() + offsets[i]);
+                progress::Counters::add(counters.m_edges_accepted, task_numbers->size());
+            } catch(...) {
+                lock_guard<mutex> lock(error_mutex);
+                if(!error){ error = current_exception(); }
+            }
+        }
+    });
+    if(error){ rethrow_exception(error); }
+
+    return edges;
+}
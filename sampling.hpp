@@ -0,0 +1,44 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "edge.hpp"
+
+/**
+ * Generate a random graph by sampling the edges without replacement, with no dedup table and no sort. The possible
+ * edges (u, v), u < v, are numbered in lexicographic order, from 0 to V * (V -1) / 2, or the ordered pairs (u, v),
+ * u != v, from 0 to V * (V -1), if the graph is directed. This range is split
+ * recursively in halves, drawing the number of edges of each half from the hypergeometric distribution, until a
+ * range holds few edges. Then the edges of the range are drawn uniformly with Floyd's algorithm, or by
+ * selection sampling if the range is dense, and sorted. The result is a uniform random graph with exactly
+ * `num_edges' edges, already sorted.
+ *
+ * Each range of the recursion draws its random numbers from its own stream, derived from the seed and the bounds
+ * of the range. Therefore the graph only depends on the seed: it does not depend on the number of threads, and
+ * the edges of any range of sources can be generated independently of the others, as with `ugg --part i/N'.
+ * The number of vertices must be at most 2^32.
+ */
+
+// Generate the edges whose source is in [first_source, last_source), with last_source clamped to num_vertices
+edge_list_t make_edges_sampling(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, uint64_t first_source = 0, uint64_t last_source = std::numeric_limits<uint64_t>::max(), bool directed = false);
+
+// The number of edges whose source is in [first_source, last_source), without generating the whole list
+uint64_t count_edges_sampling(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, uint64_t first_source, uint64_t last_source, bool directed = false);
@@ -0,0 +1,300 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "sharded.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "lib/common/error.hpp"
+#include "concurrent_set.hpp"
+#include "generator.hpp"
+#include "progress.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t QUEUE_CAPACITY = 4; // number of batches that can be buffered in each queue
+
+/**
+ * A bounded single-producer/single-consumer queue of batches of edges
+ */
+class BatchQueue {
+    const uint64_t m_batch_size; // max number of edges in each batch
+    unique_ptr<Edge[]> m_buffer; // QUEUE_CAPACITY batches
+    uint64_t m_sizes[QUEUE_CAPACITY]; // the number of edges in each batch
+    alignas(64) atomic<uint64_t> m_head; // next batch to consume, only altered by the consumer
+    alignas(64) atomic<uint64_t> m_tail; // next batch to publish, only altered by the producer
+
+    Edge* slot(uint64_t position) const { return m_buffer.get() + (position % QUEUE_CAPACITY) * m_batch_size; }
+
+public:
+    BatchQueue(uint64_t batch_size) : m_batch_size(batch_size), m_buffer(new Edge[QUEUE_CAPACITY * batch_size]), m_head(0), m_tail(0) { }
+
+    // Producer, copy the batch of `count' <= batch_size edges in the queue. Return false if the queue is full.
+    bool push(const Edge* batch, uint64_t count){
+        assert(count <= m_batch_size);
+        uint64_t tail = m_tail.load(memory_order_relaxed);
+        if(tail - m_head.load(memory_order_acquire) == QUEUE_CAPACITY) return false;
+        memcpy(slot(tail), batch, count * sizeof(Edge));
+        m_sizes[tail % QUEUE_CAPACITY] = count;
+        m_tail.store(tail +1, memory_order_release);
+        return true;
+    }
+
+    // Consumer, retrieve the next batch to process and its number of edges, or nullptr if the queue is empty
+    const Edge* front(uint64_t* out_count) const {
+        uint64_t head = m_head.load(memory_order_relaxed);
+        if(head == m_tail.load(memory_order_acquire)) return nullptr;
+        *out_count = m_sizes[head % QUEUE_CAPACITY];
+        return slot(head);
+    }
+
+    // Consumer, release the batch returned by #front
+    void pop(){
+        m_head.store(m_head.load(memory_order_relaxed) +1, memory_order_release);
+    }
+};
+
+/**
+ * A hash set of packed edges, based on open addressing with linear probing. Not thread safe.
+ */
+class LocalEdgeSet {
+    vector<uint64_t, LargeArrayAllocator<uint64_t>> m_slots; // 0 = empty slot
+    uint64_t m_size = 0; // number of edges in the set
+    uint64_t m_num_rehashes = 0; // number of times the table has been grown
+
+    void grow(){
+        m_num_rehashes++;
+        decltype(m_slots) slots(m_slots.size() * 2, 0);
+        swap(slots, m_slots);
+        for(uint64_t key : slots){
+            if(key != 0){ insert_slot(key); }
+        }
+    }
+
+    bool insert_slot(uint64_t key){
+        const uint64_t mask = m_slots.size() -1;
+        uint64_t slot = hash_mix(key) & mask;
+        while(m_slots[slot] != 0){
+            if(m_slots[slot] == key) return false;
+            slot = (slot +1) & mask;
+        }
+        m_slots[slot] = key;
+        return true;
+    }
+
+public:
+    // Size the table for the expected number of edges
+    void reserve(uint64_t num_edges){
+        uint64_t capacity = 64;
+        while(capacity < 2 * num_edges){ capacity *= 2; }
+        m_slots.assign(capacity, 0);
+    }
+
+    // Insert the given edge, return true if it was not already present
+    bool insert(const Edge& edge){
+        if(2 * (m_size +1) > m_slots.size()){ grow(); } // keep the load factor <= 1/2
+        bool inserted = insert_slot(pack_edge(edge));
+        m_size += inserted;
+        return inserted;
+    }
+
+    // Compute the probe lengths of the edges in the set
+    DedupStatistics statistics() const {
+        DedupStatistics stats;
+        const uint64_t mask = m_slots.size() -1;
+        for(uint64_t i = 0; i < m_slots.size(); i++){
+            if(m_slots[i] == 0) continue;
+            uint64_t probe_length = ((i - (hash_mix(m_slots[i]) & mask)) & mask) +1; // distance from the home slot
+            stats.m_num_probes += probe_length;
+            stats.m_num_keys++;
+            stats.m_max_probe_length = max(stats.m_max_probe_length, probe_length);
+        }
+        stats.m_num_rehashes = m_num_rehashes;
+        return stats;
+    }
+};
+
+/**
+ * The edges with the source in a given range, only accessed by the thread owning the shard
+ */
+struct alignas(64) Shard {
+    LocalEdgeSet m_edges_created; // to discard the duplicates
+    vector<Edge> m_edges; // the edges accepted
+    DedupStatistics m_statistics; // of m_edges_created, before being released
+};
+
+} // anonymous namespace
+
+edge_list_t make_edges_sharded(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, uint64_t num_shards, uint64_t batch_size, DedupStatistics* out_statistics, bool directed){
+    if(num_vertices > ConcurrentEdgeSet::MAX_NUM_VERTICES){ ERROR("Too many vertices for the sharded generator: " << num_vertices); }
+    if(num_threads < 1) num_threads = 1;
+    if(num_shards < 1) num_shards = 1;
+    if(batch_size < 1) batch_size = 1;
+
+    // the first source of each shard, balanced by the number of possible edges in the shard
+    const vector<uint64_t> boundaries = split_sources(num_vertices, num_shards, directed);
+    auto get_shard = [&boundaries](uint64_t source) -> uint64_t {
+        return find_source_part(boundaries, source);
+    };
+    auto get_owner = [num_threads](uint64_t shard) -> int { return shard % num_threads; };
+
+    vector<Shard> shards(num_shards);
+    vector<unique_ptr<BatchQueue>> queues; // queues[producer * num_threads + consumer]
+    queues.reserve(num_threads * num_threads);
+    for(int i = 0; i < num_threads * num_threads; i++){ queues.emplace_back(new BatchQueue(batch_size)); }
+    vector<unique_ptr<Edge[]>> outgoing(num_threads); // outgoing[producer], a batch being filled for each owner
+    // the quota: the producers only draw a candidate after reserving it, while accepted + in flight < num_edges, so
+    // that the edges accepted never exceed num_edges and there is no surplus to trim
+    atomic<uint64_t> num_edges_accepted = 0;
+    atomic<uint64_t> num_edges_in_flight = 0; // candidates reserved and not processed yet by their owner
+
+    // consumer side, dedup a batch of edges owned by the given thread
+    auto process_batch = [&](int thread_id, const Edge* batch, uint64_t count){
+        uint64_t num_inserted = 0;
+        for(uint64_t i = 0; i < count; i++){
+            uint64_t shard = get_shard(batch[i].m_source);
+            assert(get_owner(shard) == thread_id);
+            if(shards[shard].m_edges_created.insert(batch[i])){
+                shards[shard].m_edges.push_back(batch[i]);
+                num_inserted++;
+            }
+        }
+        progress::Counters& counters = progress::counters(thread_id);
+        progress::Counters::add(counters.m_duplicates, count - num_inserted);
+        progress::Counters::add(counters.m_edges_accepted, num_inserted);
+        num_edges_accepted.fetch_add(num_inserted); // first, so that accepted + in flight never drops below the true value
+        num_edges_in_flight.fetch_sub(count);
+    };
+    auto process_incoming_batches = [&](int thread_id){
+        for(int producer = 0; producer < num_threads; producer++){
+            BatchQueue* queue = queues[producer * num_threads + thread_id].get();
+            const Edge* batch = nullptr;
+            uint64_t count = 0;
+            while((batch = queue->front(&count)) != nullptr){
+                process_batch(thread_id, batch, count);
+                queue->pop();
+            }
+        }
+    };
+    // reserve up to batch_size candidates, return the number reserved, 0 if the whole quota is accepted or in flight
+    auto reserve = [&]() -> uint64_t {
+        uint64_t in_flight = num_edges_in_flight.load();
+        uint64_t count = 0;
+        do {
+            uint64_t accepted = num_edges_accepted.load();
+            if(accepted + in_flight >= num_edges) return 0;
+            count = min(batch_size, num_edges - accepted - in_flight);
+        } while(!num_edges_in_flight.compare_exchange_weak(in_flight, in_flight + count));
+        return count;
+    };
+
+    run_in_parallel(num_threads, [&](int thread_id){
+        // let the owner first-touch its own shards
+        const uint64_t expected_edges_per_shard = num_edges / num_shards + num_edges / num_shards / 8 +1;
+        for(uint64_t s = thread_id; s < num_shards; s += num_threads){
+            shards[s].m_edges_created.reserve(expected_edges_per_shard);
+            shards[s].m_edges.reserve(expected_edges_per_shard);
+        }
+
+        // producer side, draw the candidates and route them to the owner of their shard
+        trace::Span span_generate { "sharded.generate" };
+        progress::Counters& counters = progress::counters(thread_id);
+        std::mt19937_64 random_generator { seed + thread_id };
+        uniform_int_distribution<uint64_t> uniform_distribution {0, num_vertices -1}; // [a, b]
+        outgoing[thread_id].reset(new Edge[num_threads * batch_size]);
+        vector<uint64_t> batch_sz(num_threads, 0); // number of edges in the outgoing batch of each owner
+        auto send = [&](int owner){
+            BatchQueue* queue = queues[thread_id * num_threads + owner].get();
+            while(!queue->push(outgoing[thread_id].get() + owner * batch_size, batch_sz[owner])){
+                process_incoming_batches(thread_id); // the owner may be waiting for us to drain our queues
+            }
+            batch_sz[owner] = 0;
+        };
+
+        uint64_t num_reserved = 0;
+        while(num_edges_accepted.load(memory_order_relaxed) < num_edges){
+            if(num_reserved == 0 && (num_reserved = reserve()) == 0){
+                // the rest of the quota is in flight: send our partial batches and serve the other producers, until
+                // either the quota is filled or the duplicates among the candidates in flight release part of it
+                for(int owner = 0; owner < num_threads; owner++){
+                    if(batch_sz[owner] > 0){ send(owner); }
+                }
+                process_incoming_batches(thread_id);
+                this_thread::yield();
+                continue;
+            }
+
+            const uint64_t source = uniform_distribution(random_generator);
+            const uint64_t destination = uniform_distribution(random_generator);
+            const Edge edge = directed ? Edge::directed(source, destination) : Edge{ source, destination };
+            if(edge.m_source == edge.m_destination){ // try again
+                progress::Counters::add(counters.m_self_loops);
+                continue;
+            }
+            num_reserved--;
+            int owner = get_owner(get_shard(edge.m_source));
+            Edge* batch = outgoing[thread_id].get() + owner * batch_size;
+            batch[batch_sz[owner]++] = edge;
+            if(batch_sz[owner] == batch_size){
+                send(owner);
+                process_incoming_batches(thread_id);
+            }
+        }
+        // once the quota is filled, no candidate is left in flight, in the queues or in the outgoing batches
+    });
+    assert(num_edges_accepted == num_edges && num_edges_in_flight == 0);
+    queues.clear();
+    outgoing.clear();
+
+    // no other thread will alter the shards of this thread anymore
+    run_in_parallel(num_threads, [&](int thread_id){
+        for(uint64_t s = thread_id; s < num_shards; s += num_threads){
+            trace::Span span { "sharded.sort", s };
+            vector<Edge>& shard_edges = shards[s].m_edges;
+            sort(begin(shard_edges), end(shard_edges));
+            if(out_statistics != nullptr){ shards[s].m_statistics = shards[s].m_edges_created.statistics(); }
+            shards[s].m_edges_created = LocalEdgeSet{}; // release the memory
+        }
+    });
+    if(out_statistics != nullptr){
+        *out_statistics = DedupStatistics{};
+        for(auto& shard : shards){ out_statistics->merge(shard.m_statistics); }
+    }
+
+    // concatenate the shards
+    vector<uint64_t> offsets(num_shards +1, 0);
+    for(uint64_t s = 0; s < num_shards; s++){ offsets[s +1] = offsets[s] + shards[s].m_edges.size(); }
+    assert(offsets[num_shards] == num_edges && "The number of edges created does not match what the user requested");
+    edge_list_t edges(offsets[num_shards]);
+    run_in_parallel(num_threads, [&](int thread_id){
+        for(uint64_t s = thread_id; s < num_shards; s += num_threads){
+            trace::Span span { "sharded.concat", s };
+            copy(begin(shards[s].m_edges), end(shards[s].m_edges), begin(edges) + offsets[s]);
+            shards[s].m_edges = vector<Edge>{};
+        }
+    });
+
+    return edges;
+}
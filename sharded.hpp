@@ -0,0 +1,38 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "edge.hpp"
+
+/**
+ * Generate a random graph with the given number of edges, partitioning the edges by source in `num_shards'
+ * ranges. Each shard is owned by a single thread, which is the only one that dedups and stores the edges
+ * of the shard, in its own private hash set. The candidate edges are routed to the owner of their shard through
+ * single-producer/single-consumer queues, in batches of `batch_size' edges. The producers reserve each candidate
+ * before drawing it, as long as the edges accepted plus the candidates in flight are less than `num_edges', so that
+ * no more than `num_edges' edges are ever accepted. At the end, each owner sorts its shards and the shards are
+ * concatenated, so that the list of edges returned is already sorted.
+ *
+ * The shards are balanced by the number of possible edges in each source range, rather than by the number of
+ * vertices. The number of vertices must be at most 2^32. The statistics, if requested, are summed over the hash
+ * sets of all shards. If `directed' is true, the edges are ordered pairs (u, v), u != v.
+ */
+edge_list_t make_edges_sharded(uint64_t num_vertices, uint64_t num_edges, uint64_t seed, int num_threads, uint64_t num_shards, uint64_t batch_size, DedupStatistics* out_statistics = nullptr, bool directed = false);
@@ -0,0 +1,184 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "sort.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "generator.hpp"
+#include "numa.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+constexpr uint64_t MIN_EDGES_PER_THREAD = 1ull << 16;
+
+void sort_edges(edge_list_t& edges, uint64_t num_vertices, int num_threads, vector<size_t>* out_bytes_per_node, bool directed){
+    if(out_bytes_per_node != nullptr){ out_bytes_per_node->assign(numa::num_nodes(), 0); }
+
+    num_threads = max<int64_t>(1, min<int64_t>(num_threads, edges.size() / MIN_EDGES_PER_THREAD));
+    if(num_threads == 1 || num_vertices > (1ull<<32) /* split_sources would overflow */){
+        trace::Span span { "sort" };
+        sort(begin(edges), end(edges));
+        return;
+    }
+
+    const vector<uint64_t> boundaries = split_sources(num_vertices, num_threads, directed);
+    const uint64_t num_edges = edges.size();
+    auto get_slice = [&](int thread_id, uint64_t* out_start, uint64_t* out_end){
+        *out_start = num_edges * thread_id / num_threads;
+        *out_end = num_edges * (thread_id +1) / num_threads;
+    };
+
+    // histogram, counts[t * num_threads + b] is the number of edges in the slice of the thread t that belong to the bucket b
+    vector<uint64_t> counts(num_threads * num_threads, 0);
+    run_in_parallel(num_threads, [&](int thread_id){
+        uint64_t start, end;
+        get_slice(thread_id, &start, &end);
+        trace::Span span { "sort.histogram", start };
+        vector<uint64_t> count(num_threads, 0); // local, to avoid false sharing
+        for(uint64_t i = start; i < end; i++){
+            count[find_source_part(boundaries, edges[i].m_source)]++;
+        }
+        copy(count.begin(), count.end(), counts.begin() + thread_id * num_threads);
+    });
+
+    // where each thread writes the edges of each bucket
+    vector<uint64_t> buckets(num_threads +1, 0);
+    vector<uint64_t> offsets(num_threads * num_threads);
+    for(int b = 0; b < num_threads; b++){
+        uint64_t offset = buckets[b];
+        for(int t = 0; t < num_threads; t++){
+            offsets[t * num_threads + b] = offset;
+            offset += counts[t * num_threads + b];
+        }
+        buckets[b +1] = offset;
+    }
+    assert(buckets[num_threads] == num_edges);
+
+    // place each bucket on the node of the thread that will sort it, before any thread touches it
+    edge_list_t output(num_edges);
+    for(int b = 0; b < num_threads; b++){
+        numa::bind_memory(output.data() + buckets[b], (buckets[b +1] - buckets[b]) * sizeof(Edge), numa::node_of_thread(b, num_threads));
+    }
+
+    // scatter the edges in their buckets
+    run_in_parallel(num_threads, [&](int thread_id){
+        uint64_t start, end;
+        get_slice(thread_id, &start, &end);
+        trace::Span span { "sort.scatter", start };
+        vector<uint64_t> offset(begin(offsets) + thread_id * num_threads, begin(offsets) + (thread_id +1) * num_threads);
+        for(uint64_t i = start; i < end; i++){
+            const Edge& edge = edges[i];
+            output[offset[find_source_part(boundaries, edge.m_source)]++] = edge;
+        }
+    });
+    edges = edge_list_t{}; // release the memory
+
+    // sort each bucket
+    run_in_parallel(num_threads, [&](int thread_id){
+        trace::Span span { "sort.bucket", buckets[thread_id] };
+        sort(begin(output) + buckets[thread_id], begin(output) + buckets[thread_id +1]);
+    });
+
+    if(out_bytes_per_node != nullptr){ // two reads and one write of each slice, one pass over each bucket
+        for(int t = 0; t < num_threads; t++){
+            uint64_t start, end;
+            get_slice(t, &start, &end);
+            (*out_bytes_per_node)[numa::node_of_thread(t, num_threads)] += (3 * (end - start) + (buckets[t +1] - buckets[t])) * sizeof(Edge);
+        }
+    }
+
+    edges = move(output);
+}
+
+void symmetrize_edges(edge_list_t& edges, uint64_t num_vertices, int num_threads){
+    num_threads = max<int64_t>(1, min<int64_t>(num_threads, edges.size() / MIN_EDGES_PER_THREAD));
+    const uint64_t num_edges = edges.size();
+    auto get_slice = [&](int thread_id, uint64_t* out_start, uint64_t* out_end){
+        *out_start = num_edges * thread_id / num_threads;
+        *out_end = num_edges * (thread_id +1) / num_threads;
+    };
+
+    // in the symmetric graph, all vertices have the same expected degree
+    vector<uint64_t> boundaries(num_threads +1);
+    for(int b = 0; b <= num_threads; b++){ boundaries[b] = (unsigned __int128) num_vertices * b / num_threads; }
+
+    // histogram, counts[t * num_threads + b] is the number of edges in the slice of the thread t whose destination is in the bucket b
+    vector<uint64_t> counts(num_threads * num_threads, 0);
+    run_in_parallel(num_threads, [&](int thread_id){
+        uint64_t start, end;
+        get_slice(thread_id, &start, &end);
+        trace::Span span { "symmetrize.histogram", start };
+        vector<uint64_t> count(num_threads, 0); // local, to avoid false sharing
+        for(uint64_t i = start; i < end; i++){
+            count[find_source_part(boundaries, edges[i].m_destination)]++;
+        }
+        copy(count.begin(), count.end(), counts.begin() + thread_id * num_threads);
+    });
+
+    // where each thread writes the reversed edges of each bucket
+    vector<uint64_t> buckets(num_threads +1, 0);
+    vector<uint64_t> offsets(num_threads * num_threads);
+    for(int b = 0; b < num_threads; b++){
+        uint64_t offset = buckets[b];
+        for(int t = 0; t < num_threads; t++){
+            offsets[t * num_threads + b] = offset;
+            offset += counts[t * num_threads + b];
+        }
+        buckets[b +1] = offset;
+    }
+    assert(buckets[num_threads] == num_edges);
+
+    // scatter the reversed edges in their buckets, in the order of the input, i.e. sorted by destination within each vertex
+    edge_list_t reversed(num_edges);
+    run_in_parallel(num_threads, [&](int thread_id){
+        uint64_t start, end;
+        get_slice(thread_id, &start, &end);
+        trace::Span span { "symmetrize.scatter", start };
+        vector<uint64_t> offset(begin(offsets) + thread_id * num_threads, begin(offsets) + (thread_id +1) * num_threads);
+        for(uint64_t i = start; i < end; i++){
+            const Edge& edge = edges[i];
+            reversed[offset[find_source_part(boundaries, edge.m_destination)]++] = Edge::directed(edge.m_destination, edge.m_source);
+        }
+    });
+
+    // the original edges of each bucket
+    vector<uint64_t> sources(num_threads +1);
+    for(int b = 0; b <= num_threads; b++){
+        const uint64_t vertex = boundaries[b];
+        sources[b] = partition_point(begin(edges), end(edges), [vertex](const Edge& e){ return e.m_source < vertex; }) - begin(edges);
+    }
+
+    // each thread places the edges of its vertices: the reversed edges, whose destination is less than the vertex,
+    // followed by the original edges, whose destination is greater
+    edge_list_t output(2 * num_edges);
+    run_in_parallel(num_threads, [&](int thread_id){
+        trace::Span span { "symmetrize.place", boundaries[thread_id] };
+        const uint64_t first_vertex = boundaries[thread_id];
+        const uint64_t base = buckets[thread_id] + sources[thread_id];
+        vector<uint64_t> position(boundaries[thread_id +1] - first_vertex +1, 0); // degrees, then offsets
+        for(uint64_t i = buckets[thread_id]; i < buckets[thread_id +1]; i++){ position[reversed[i].m_source - first_vertex +1]++; }
+        for(uint64_t i = sources[thread_id]; i < sources[thread_id +1]; i++){ position[edges[i].m_source - first_vertex +1]++; }
+        for(size_t i = 1; i < position.size(); i++){ position[i] += position[i -1]; }
+        for(uint64_t i = buckets[thread_id]; i < buckets[thread_id +1]; i++){ output[base + position[reversed[i].m_source - first_vertex]++] = reversed[i]; }
+        for(uint64_t i = sources[thread_id]; i < sources[thread_id +1]; i++){ output[base + position[edges[i].m_source - first_vertex]++] = edges[i]; }
+    });
+
+    edges = move(output);
+}
@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "edge.hpp"
+
+/**
+ * Sort the edges by source and destination. With multiple threads, the edges are first scattered into one
+ * bucket per thread, by ranges of sources with the same number of possible edges, and then each thread sorts
+ * its own bucket. Each bucket is placed on the NUMA node of the thread sorting it. The scatter needs a second
+ * array as large as the input.
+ * If `out_bytes_per_node' is not null, it reports the amount of data read & written by the threads of each node.
+ * If `directed' is true, the edges are ordered pairs and the buckets are balanced accordingly.
+ */
+void sort_edges(edge_list_t& edges, uint64_t num_vertices, int num_threads, std::vector<size_t>* out_bytes_per_node = nullptr, bool directed = false);
+
+/**
+ * Add the reverse (v, u) of each edge (u, v) of a list sorted by source and destination, keeping the list sorted.
+ * It is a counting sort of the reversed edges by their source: each thread scatters a slice of the input into one
+ * bucket per thread, by ranges of vertices, preserving the order, and then each thread places the edges of its
+ * vertices, first the reversed edges and then the original ones. No comparison sort is needed, but the scatter needs
+ * a second array as large as the input, on top of the result twice as large.
+ */
+void symmetrize_edges(edge_list_t& edges, uint64_t num_vertices, int num_threads);
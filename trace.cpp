@@ -0,0 +1,152 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "lib/common/error.hpp"
+
+using namespace std;
+
+namespace trace {
+
+namespace {
+
+struct Event {
+    const char* m_name;
+    uint64_t m_argument;
+    uint64_t m_start; // nanosecs since the tracing was enabled
+    uint64_t m_end;
+};
+
+// The ring buffer of a logical thread, only accessed by the thread owning it
+struct Buffer {
+    vector<Event> m_events; // the spans retained
+    uint64_t m_num_events = 0; // total number of spans recorded, including those overwritten
+
+    Buffer(uint64_t capacity) : m_events(capacity) { }
+
+    void push(const Event& event){
+        m_events[m_num_events % m_events.size()] = event;
+        m_num_events++;
+    }
+};
+
+} // anonymous namespace
+
+static bool g_enabled = false; // whether the spans should be recorded
+static uint64_t g_buffer_capacity = DEFAULT_BUFFER_CAPACITY; // number of spans retained by each thread
+static chrono::steady_clock::time_point g_epoch; // when the tracing started
+static mutex g_mutex; // protect the list of buffers and the interned names
+static vector<unique_ptr<Buffer>> g_buffers; // one for each logical thread
+static deque<string> g_names; // interned names
+static thread_local int g_thread_id = 0; // logical id of the current thread
+static thread_local Buffer* g_buffer = nullptr; // ring buffer of the current thread
+
+static uint64_t now(){
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - g_epoch).count() +1; // 0 is reserved for `disabled'
+}
+
+static Buffer* get_buffer(int thread_id){
+    lock_guard<mutex> lock(g_mutex);
+    if(static_cast<size_t>(thread_id) >= g_buffers.size()){ g_buffers.resize(thread_id +1); }
+    if(!g_buffers[thread_id]){ g_buffers[thread_id].reset(new Buffer(g_buffer_capacity)); }
+    return g_buffers[thread_id].get();
+}
+
+Span::Span(const char* name, uint64_t argument) : m_name(name), m_argument(argument), m_start(g_enabled ? now() : 0) {
+
+}
+
+Span::~Span(){
+    if(m_start == 0) return;
+    if(g_buffer == nullptr){ g_buffer = get_buffer(g_thread_id); }
+    g_buffer->push(Event{ m_name, m_argument, m_start -1, now() -1 });
+}
+
+void enable(uint64_t buffer_capacity){
+    g_buffer_capacity = max<uint64_t>(1, buffer_capacity);
+    g_epoch = chrono::steady_clock::now();
+    g_enabled = true;
+}
+
+bool is_enabled(){
+    return g_enabled;
+}
+
+void set_thread_id(int thread_id){
+    g_thread_id = thread_id;
+    g_buffer = nullptr; // fetched on the first span
+}
+
+const char* intern(const string& name){
+    lock_guard<mutex> lock(g_mutex);
+    for(auto& s : g_names){
+        if(s == name) return s.c_str();
+    }
+    g_names.push_back(name);
+    return g_names.back().c_str();
+}
+
+static void save_event(fstream& out, const Event& event, int thread_id){
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.3f, \"dur\": %.3f", event.m_start / 1000.0, (event.m_end - event.m_start) / 1000.0);
+    out << ",\n{ \"name\": \"" << event.m_name << "\", \"cat\": \"ugg\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread_id
+        << ", \"ts\": " << buffer << ", \"args\": { \"arg\": " << event.m_argument << " } }";
+}
+
+void save(const string& path){
+    fstream out { path, ios::out };
+    if(!out.good()) ERROR("Cannot create the file `" << path << "'");
+
+    lock_guard<mutex> lock(g_mutex);
+    uint64_t num_overwritten = 0;
+    out << "{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out << "{ \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": { \"name\": \"ugg\" } }";
+    for(size_t thread_id = 0; thread_id < g_buffers.size(); thread_id++){
+        Buffer* buffer = g_buffers[thread_id].get();
+        if(buffer == nullptr) continue;
+        out << ",\n{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread_id << ", \"args\": { \"name\": \"";
+        if(thread_id == 0){ out << "main"; } else { out << "worker " << (thread_id -1); }
+        out << "\" } }";
+
+        // oldest first
+        const uint64_t capacity = buffer->m_events.size();
+        const uint64_t num_retained = min(capacity, buffer->m_num_events);
+        num_overwritten += buffer->m_num_events - num_retained;
+        for(uint64_t i = buffer->m_num_events - num_retained; i < buffer->m_num_events; i++){
+            save_event(out, buffer->m_events[i % capacity], thread_id);
+        }
+    }
+    out << "\n] }\n";
+    out.close();
+    if(out.fail()) ERROR("Cannot write the file `" << path << "'");
+
+    if(num_overwritten > 0){
+        cerr << "[trace] " << num_overwritten << " spans were overwritten, the ring buffers retain only the last " << g_buffer_capacity << " spans of each thread" << endl;
+    }
+}
+
+} // namespace trace
@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Timeline of the spans executed by each thread, saved in the Chrome trace format, which can be loaded in
+ * chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Each logical thread records its spans in its own ring buffer, without any synchronisation. The main thread
+ * is the logical thread 0, while the worker i of #run_in_parallel is the logical thread i + 1. When a buffer is
+ * full, the oldest spans are overwritten.
+ */
+namespace trace {
+
+// Default number of spans that can be retained by each thread
+constexpr uint64_t DEFAULT_BUFFER_CAPACITY = 1ull << 16;
+
+/**
+ * Record a span from its construction to its destruction. The name must be a string literal, or otherwise
+ * outlive the program. No-op if tracing is not enabled.
+ */
+class Span {
+    const char* m_name; // name of the span
+    uint64_t m_argument; // user argument, e.g. the first item processed in the span
+    uint64_t m_start; // start time, in nanosecs, or 0 if tracing was not enabled
+
+public:
+    Span(const char* name, uint64_t argument = 0);
+    ~Span();
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+};
+
+// Start recording the spans, each thread retains the last `buffer_capacity' spans
+void enable(uint64_t buffer_capacity = DEFAULT_BUFFER_CAPACITY);
+
+// Whether #enable has been invoked
+bool is_enabled();
+
+// Set the logical id of the calling thread, 0 for the main thread, i + 1 for the worker i
+void set_thread_id(int thread_id);
+
+// Retrieve a copy of the given name that outlives the program, to be used in a Span
+const char* intern(const std::string& name);
+
+// Save the spans recorded so far in the given file, in the Chrome trace format
+void save(const std::string& path);
+
+} // namespace trace
@@ -15,42 +15,51 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cinttypes>
 #include <cmath>
 #include <ctime>
 #include <cstdlib>
-#include <fstream>
+#include <cstdio>
 #include <iostream>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_set>
+#include <unistd.h>
 
 #include "lib/common/error.hpp"
 #include "lib/common/filesystem.hpp"
 #include "lib/common/quantity.hpp"
 #include "lib/cxxopts.hpp"
-#include "lib/cuckoohash.hpp"
+#include "benchmark.hpp"
+#include "bitmap.hpp"
+#include "components.hpp"
+#include "concurrent_set.hpp"
+#include "cuckoo_dedup.hpp"
+#include "edge.hpp"
+#include "generator.hpp"
+#include "memory.hpp"
+#include "numa.hpp"
+#include "output.hpp"
+#include "perf.hpp"
+#include "planner.hpp"
+#include "progress.hpp"
+#include "report.hpp"
+#include "sampling.hpp"
+#include "sharded.hpp"
+#include "sort.hpp"
+#include "trace.hpp"
+#include "weights.hpp"
 
 using namespace common;
 using namespace std;
 
 // data structures
 using graph_raw_t = pair</* vertices */ vector<uint64_t>, /* edges */ vector<pair<uint64_t, uint64_t>>>;
-struct Edge {
-    uint64_t m_source;
-    uint64_t m_destination;
-
-    Edge(uint64_t source, uint64_t destination) : m_source(min(source, destination)), m_destination(max(source,destination)){ }
-
-    // Check whether the two edges are equal
-    bool operator==(const Edge& e) const noexcept { return e.m_source == m_source && e.m_destination == m_destination; }
-    bool operator!=(const Edge& e) const noexcept { return !(*this == e); }
-};
-namespace std {
-template<> struct hash<::Edge>{ // hash function
-    size_t operator()(const Edge& e) const { return hash<uint64_t>{}(e.m_source) ^ hash<uint64_t>{}(e.m_destination); }
-};
-} // namespace std
 
 // globals
 double g_exp_factor_vertex_id; // the maximum vertex id to assign to the nodes in the graph
@@ -58,43 +67,87 @@ uint64_t g_num_edges; // the total number of edges to create
 uint64_t g_num_vertices; // number of vertices to create
 string g_output_prefix; // path where to save the generated files
 uint64_t g_seed = std::random_device{}(); // the seed to use for the random generator
+int g_num_threads = std::thread::hardware_concurrency(); // number of threads to use to generate the edges
+DedupBackend g_dedup_backend = DedupBackend::AUTO; // the data structure to use to discard duplicate edges
+uint64_t g_memory_budget; // max amount of memory, in bytes, that the dedup data structure can take
+uint64_t g_dedup_num_shards = 0; // sharded dedup backend, number of shards, 0 => one per thread
+uint64_t g_dedup_batch_size = 256; // sharded dedup backend, number of edges in each batch sent to the owner of a shard
+string g_report_path; // where to save the statistics of the run in JSON, empty => do not save them
+string g_trace_path; // where to save the timeline of the threads, empty => do not record it
+double g_progress_interval = 0; // how often to print the progress, in seconds, 0 => only on SIGUSR1
+bool g_benchmark = false; // run the end-to-end benchmark, rather than generating a single graph
+vector<uint64_t> g_benchmark_vertices; // benchmark mode, the number of vertices of each graph
+vector<uint64_t> g_benchmark_edges; // benchmark mode, the number of edges of each graph, as given by the user
+vector<int> g_benchmark_threads; // benchmark mode, the number of threads of each run
+int g_benchmark_repetitions = 1; // benchmark mode, how many times each run is repeated, only the fastest is retained
+bool g_dry_run = false; // only show the plan, without generating the graph
+bool g_mmap_output = false; // whether to save the edges through a memory mapping of the file, formatted in parallel
+uint64_t g_num_output_shards = 0; // number of files for the edges, 0 => a single file, without suffix
+bool g_symmetric = false; // whether to save both directions of each edge, (u, v) and (v, u)
+bool g_directed = false; // whether to generate a directed graph, where (u, v) and (v, u) are distinct edges
+uint64_t g_partition_rows = 0; // --partition, the rows of the grid partitioning of the edges, 0 => not partitioned
+uint64_t g_partition_columns = 0; // --partition, the columns of the grid partitioning, 1 for a 1D partitioning
+uint64_t g_part = 0; // --part i/N, the part of the graph to generate
+uint64_t g_num_parts = 0; // --part i/N, the number of parts of the graph, 0 => generate the whole graph
+uint64_t g_part_first_source = 0; // --part, the first source of the part, as a position in the sorted list of vertices
+uint64_t g_part_last_source = 0; // --part, the last source of the part, excluded
+uint64_t g_part_num_edges = 0; // --part, the number of edges of the part
+bool g_sssp_whole_graph = false; // --part, whether the part 0 regenerates all other parts to pick the SSSP source
+
+// The files saved by generate_graph
+struct GraphFiles {
+    uint64_t m_vertices_bytes = 0; // size of the vertex file
+    uint32_t m_vertices_checksum = 0; // crc32 of the vertex file
+    uint64_t m_num_edges = 0; // number of edges saved
+    uint64_t m_edges_bytes = 0; // total size of the edge files
+    uint32_t m_edges_checksum = 0; // crc32 of the edge file, or of the concatenation of its shards
+    vector<EdgeShard> m_edge_shards; // the shards of the edge file, if --shards was given, or its blocks, if --partition was given
+    uint64_t m_sssp_source = 0; // ID of the source vertex for SSSP, in the largest connected component, only for weighted graphs
+    uint64_t m_largest_component = 0; // number of vertices in the largest connected component, only for weighted graphs
+};
 
 // function prototypes
 static void parse_command_line_arguments(int argc, char* argv[]);
-static vector<Edge> make_edges();
-static vector<uint64_t> make_vertices();
-static void save_vertices(const vector<uint64_t>& vertices);
-static void save_edges(const vector<uint64_t>& vertices, const vector<Edge>& edges);
-static void save_properties();
+static void run_generator();
+static void run_benchmark();
+static GraphFiles generate_graph(const string& path_vertices, const string& path_edges);
+static edge_list_t make_edges(bool* out_sorted, DedupStatistics* out_statistics);
+static edge_list_t make_edges_hashset(DedupStatistics* out_statistics);
+static void print_generation_statistics(const DedupStatistics& dedup_statistics, uint64_t num_edges);
+static vector<size_t> edges_accepted_per_node();
+static uint64_t save_properties(const GraphFiles& files);
+static uint64_t save_manifest(const string& path_prefix, const GraphFiles& files);
+static string get_basename(const string& path_prefix);
+static string get_part_prefix(uint64_t part);
 static string get_current_datetime();
+static uint64_t resolve_num_edges(uint64_t num_edges, uint64_t num_vertices);
+static uint64_t get_vertices_file_size();
+template<typename T, typename R = T> static vector<R> parse_list(const string& list, const char* option);
 
 // entry point
 int main(int argc, char* argv[]) {
     try {
         parse_command_line_arguments(argc, argv);
+        if(g_dry_run){
+            cout << "Dry run, nothing to generate" << endl;
+            return 0;
+        } else if(g_benchmark){
+            run_benchmark();
+        } else {
+            run_generator();
+        }
 
-        cout << "Generating the list of edges ... " << endl;
-        vector<Edge> edges = make_edges();
-        std::sort(begin(edges), end(edges), [](const Edge& e1, const Edge& e2){
-            return (e1.m_source < e2.m_source) || (e1.m_source == e2.m_source && e1.m_destination < e2.m_destination);
-        });
-
-        cout << "Generating the list of vertices ..." << endl;
-        vector<uint64_t> vertices = make_vertices();
-
-        string basedir = ::common::filesystem::directory(g_output_prefix);
-        ::common::filesystem::mkdir(basedir);
-
-        cout << "Saving the list of vertices ..." << endl;
-        save_vertices(vertices);
-
-        cout << "Saving the list of edges ..." << endl;
-        save_edges(vertices, edges);
-
-        cout << "Saving the graph properties ..." << endl;
-        save_properties();
+        if(!g_report_path.empty()){
+            cout << "Saving the report in " << g_report_path << " ..." << endl;
+            report::save_json(g_report_path);
+        }
+        if(!g_trace_path.empty()){
+            cout << "Saving the trace in " << g_trace_path << " ..." << endl;
+            trace::save(g_trace_path);
+        }
 
     } catch (common::Error& e){
+        progress::stop();
         cerr << e << endl;
         cerr << "Type `" << argv[0] << " --help' to check how to run the program\n";
         cerr << "Program terminated" << endl;
@@ -106,62 +159,318 @@ int main(int argc, char* argv[]) {
     return 0;
 }
 
-#define SEQUENTIAL
-#if !defined(SEQUENTIAL)
-static vector<Edge> make_edges(){
-    cuckoohash_map<Edge, bool> edges_created;
-
-    int num_threads = std::thread::hardware_concurrency();
-    auto create_edges = [=, &edges_created](int thread_id){
-        std::mt19937_64 random_generator { g_seed + thread_id };
-        uniform_int_distribution<uint64_t> uniform_distribution {0, g_num_vertices -1}; // [a, b]
-        const uint64_t num_edges_to_create = g_num_edges / num_threads + (thread_id < (g_num_edges % num_threads));
-
-        uint64_t num_edges_created_insofar = 0;
-        while(num_edges_created_insofar < num_edges_to_create){
-            Edge edge { uniform_distribution(random_generator), uniform_distribution(random_generator) };
-            if(edge.m_source == edge.m_destination) continue; // try again
-            if(edges_created.insert(edge, true)){
-                num_edges_created_insofar++;
+static void run_generator(){
+    progress::init(g_num_threads, g_num_parts > 0 ? g_part_num_edges : g_num_edges);
+    progress::start(g_progress_interval);
+
+    if(get_output_sink() == OutputSink::FILESYSTEM){
+        string basedir = ::common::filesystem::directory(g_output_prefix);
+        ::common::filesystem::mkdir(basedir);
+    }
+
+    const string path_prefix = (g_num_parts > 0) ? get_part_prefix(g_part) : g_output_prefix;
+    GraphFiles files = generate_graph(path_prefix + ".v", path_prefix + ".e");
+
+    cout << "Saving the graph properties ..." << endl;
+    { // restrict the scope
+        report::Phase phase { "Save properties" };
+        if(g_num_parts > 0){ phase.add_bytes_written(save_manifest(path_prefix, files)); }
+        if(g_part == 0){ phase.add_bytes_written(save_properties(files)); } // only the first part describes the whole graph
+    }
+
+    progress::set_phase("Done");
+    progress::stop();
+
+    cout << "\n";
+    report::print_summary(cout);
+    cout << "\n";
+}
+
+// With --part, only the vertices and the edges of the part are saved
+static GraphFiles generate_graph(const string& path_vertices, const string& path_edges){
+    // fail fast, rather than after generating the whole graph
+    if(get_output_sink() == OutputSink::FILESYSTEM && path_edges != "/dev/null"){
+        uint64_t num_bytes = get_vertices_file_size() + estimate_edges_file_size(g_num_vertices, g_num_parts > 0 ? g_part_num_edges : g_num_edges, g_exp_factor_vertex_id);
+        if(g_symmetric){ num_bytes += estimate_edges_file_size(g_num_vertices, g_num_edges, g_exp_factor_vertex_id); }
+        check_free_space(::common::filesystem::directory(path_edges), num_bytes);
+    }
+
+    cout << "Generating the list of edges ... " << endl;
+    bool edges_sorted = false;
+    edge_list_t edges;
+    DedupStatistics dedup_statistics;
+    { // restrict the scope
+        report::Phase phase { "Generate edges" };
+        vector<size_t> accepted_before = edges_accepted_per_node();
+        edges = make_edges(&edges_sorted, &dedup_statistics);
+        phase.set_num_items(edges.size());
+        vector<size_t> bytes_per_node = edges_accepted_per_node();
+        for(size_t node = 0; node < bytes_per_node.size(); node++){ bytes_per_node[node] = (bytes_per_node[node] - accepted_before[node]) * sizeof(Edge); }
+        phase.add_bytes_per_node(bytes_per_node);
+    }
+    if(!g_benchmark){ // the progress counters are cumulative over all runs of the benchmark
+        print_generation_statistics(dedup_statistics, edges.size());
+    }
+    if(!edges_sorted){
+        report::Phase phase { "Sort edges" };
+        vector<size_t> bytes_per_node;
+        sort_edges(edges, g_num_vertices, g_num_threads, &bytes_per_node, g_directed);
+        phase.set_num_items(edges.size());
+        phase.add_bytes_per_node(bytes_per_node);
+    }
+
+    if(g_symmetric){
+        cout << "Adding the reverse of each edge ..." << endl;
+        report::Phase phase { "Symmetrize edges" };
+        symmetrize_edges(edges, g_num_vertices, g_num_threads);
+        phase.set_num_items(edges.size());
+    }
+
+    cout << "Generating the list of vertices ..." << endl;
+    vector<uint64_t> vertices;
+    { // restrict the scope
+        report::Phase phase { "Generate vertices" };
+        vertices = make_vertices(g_num_vertices, g_exp_factor_vertex_id);
+        phase.set_num_items(vertices.size());
+    }
+
+    GraphFiles files;
+    if(get_edge_weights().is_weighted() && !g_benchmark && g_part == 0){ // the source vertex of SSSP, only needed by the properties
+        cout << "Searching the largest connected component ..." << endl;
+        report::Phase phase { "Connected components" };
+        ConnectedComponents components { g_num_vertices, g_num_threads };
+        uint64_t num_edges = 0;
+        if(g_num_parts > 0 && g_sssp_whole_graph){ // the component of the whole graph, generating again the edges of the other parts, one at a time
+            vector<uint64_t> boundaries = split_sources(g_num_vertices, g_num_parts, g_directed);
+            for(uint64_t i = 0; i < g_num_parts; i++){
+                if(i == g_part){
+                    components.add_edges(edges);
+                    num_edges += edges.size();
+                } else {
+                    edge_list_t part_edges = make_edges_sampling(g_num_vertices, g_num_edges, g_seed, g_num_threads, boundaries[i], boundaries[i +1], g_directed);
+                    components.add_edges(part_edges);
+                    num_edges += part_edges.size();
+                }
             }
+        } else {
+            components.add_edges(edges);
+            num_edges = edges.size();
         }
-    };
+        LargestComponent component = components.largest_component();
+        files.m_sssp_source = vertices[component.m_vertex];
+        files.m_largest_component = component.m_num_vertices;
+        phase.set_num_items(num_edges);
+        cout << "Connected components: " << component.m_num_components << ", largest: " << component.m_num_vertices << " vertices, source vertex for SSSP: " << files.m_sssp_source << endl;
+        report::set_statistic("num_components", component.m_num_components);
+        report::set_statistic("largest_component", component.m_num_vertices);
+    }
 
-    vector<thread> threads;
-    threads.reserve(num_threads);
-    for(int thread_id = 0; thread_id < num_threads; thread_id++){
-        threads.emplace_back(create_edges, thread_id);
+    cout << "Saving the list of vertices ..." << endl;
+    { // restrict the scope
+        report::Phase phase { "Save vertices" };
+        if(g_num_parts > 0){ // the vertices of the part
+            vector<uint64_t> part_vertices(vertices.begin() + g_part_first_source, vertices.begin() + g_part_last_source);
+            files.m_vertices_bytes = save_vertices(path_vertices, part_vertices, &files.m_vertices_checksum);
+            phase.set_num_items(part_vertices.size());
+        } else {
+            files.m_vertices_bytes = save_vertices(path_vertices, vertices, &files.m_vertices_checksum);
+            phase.set_num_items(vertices.size());
+        }
+        phase.add_bytes_written(files.m_vertices_bytes);
     }
-    for(auto& t: threads) t.join();
 
-    auto lst_edges = edges_created.lock_table();
-    vector<Edge> edges;
-    edges.reserve(lst_edges.size());
-    for(auto& it_edge : lst_edges){
-        edges.push_back(it_edge.first);
+    cout << "Saving the list of edges ..." << endl;
+    { // restrict the scope
+        report::Phase phase { "Save edges" };
+        vector<size_t> bytes_per_node;
+        if(g_num_output_shards > 0){
+            files.m_edge_shards = save_edges_sharded(path_edges, vertices, edges, g_num_output_shards, g_num_threads, &files.m_edges_checksum, &bytes_per_node);
+            for(auto& shard : files.m_edge_shards){ files.m_edges_bytes += shard.m_bytes_written; }
+        } else if(g_partition_rows > 0){
+            GridPartitioning grid = make_grid_partitioning(g_num_vertices, g_partition_rows, g_partition_columns, g_symmetric || g_directed);
+            files.m_edge_shards = save_edges_partitioned(path_edges, vertices, edges, grid, g_num_threads, &bytes_per_node);
+            uint64_t max_edges = 0;
+            for(auto& block : files.m_edge_shards){
+                files.m_edges_bytes += block.m_bytes_written;
+                max_edges = max(max_edges, block.m_num_edges);
+            }
+            double balance = edges.empty() ? 1.0 : static_cast<double>(max_edges) * files.m_edge_shards.size() / edges.size();
+            cout << "Partitions: " << files.m_edge_shards.size() << ", max edges: " << max_edges << ", balance (max / avg): " << balance << endl;
+            report::set_statistic("partition_balance", balance);
+        } else if(g_mmap_output){
+            files.m_edges_bytes = save_edges_mmap(path_edges, vertices, edges, g_num_threads, &files.m_edges_checksum, &bytes_per_node);
+        } else {
+            files.m_edges_bytes = save_edges(path_edges, vertices, edges, &files.m_edges_checksum);
+        }
+        files.m_num_edges = edges.size();
+        phase.add_bytes_written(files.m_edges_bytes);
+        phase.add_bytes_per_node(bytes_per_node);
+        phase.set_num_items(edges.size());
     }
-    assert(edges.size() == g_num_edges && "The number of edges created does not match what the user requested");
 
-//    lst_edges.unlock(); // not sure whether it's necessary
-    return edges;
+    // the last two phases are the saves
+    const auto& phases = report::phases();
+    double save_time = phases[phases.size() -2].m_wall_time + phases.back().m_wall_time;
+    uint64_t save_bytes = phases[phases.size() -2].m_bytes_written + phases.back().m_bytes_written;
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%.1f MB/s", save_time > 0 ? save_bytes / save_time / 1048576.0 : 0.0);
+    cout << "Write throughput: " << buffer << " (" << (get_output_sink() != OutputSink::FILESYSTEM ? to_string(get_output_sink()) : is_direct_io() ? "direct I/O" : g_mmap_output ? "mmap" : "page cache") << ")\n";
+    report::set_statistic("write_throughput", save_time > 0 ? save_bytes / save_time : 0.0);
+    if(g_partition_rows == 0){
+        snprintf(buffer, sizeof(buffer), "vertices: %08x, edges: %08x", files.m_vertices_checksum, files.m_edges_checksum);
+        report::set_statistic("crc32_edges", static_cast<uint64_t>(files.m_edges_checksum));
+    } else { // the checksum of each block is in the properties
+        snprintf(buffer, sizeof(buffer), "vertices: %08x", files.m_vertices_checksum);
+    }
+    cout << "Checksums (CRC-32) of the content, " << buffer << endl;
+    report::set_statistic("crc32_vertices", static_cast<uint64_t>(files.m_vertices_checksum));
+
+    return files;
 }
-#else
-static vector<Edge> make_edges(){
-    unordered_set<Edge> edges_created;
-    std::mt19937_64 random_generator { g_seed };
-    uniform_int_distribution<uint64_t> uniform_distribution {0, g_num_vertices -1}; // [a, b]
-    uint64_t num_edges_created_insofar = 0;
-
-    while(num_edges_created_insofar < g_num_edges){
-        Edge edge { uniform_distribution(random_generator), uniform_distribution(random_generator) };
-        if(edge.m_source == edge.m_destination) continue; // try again
-        if(edges_created.count(edge) == 0){
-            edges_created.insert(edge);
-            num_edges_created_insofar++;
+
+static void run_benchmark(){
+    // the graphs to generate
+    vector<pair<uint64_t, uint64_t>> graphs; // vertices, edges
+    for(uint64_t num_vertices : g_benchmark_vertices){
+        for(uint64_t num_edges : g_benchmark_edges){
+            num_edges = resolve_num_edges(num_edges, num_vertices);
+            if(num_edges > max_num_edges(num_vertices, g_directed)){
+                cout << "Skipping the graph with " << num_vertices << " vertices and " << num_edges << " edges: too dense" << endl;
+            } else {
+                graphs.emplace_back(num_vertices, num_edges);
+            }
         }
     }
+    if(graphs.empty()){ ERROR("No graphs to generate"); }
+
+    uint64_t total_edges = 0;
+    for(auto& graph : graphs){ total_edges += graph.second * g_benchmark_threads.size() * g_benchmark_repetitions; }
+    progress::init(*max_element(begin(g_benchmark_threads), end(g_benchmark_threads)), total_edges);
+    progress::start(g_progress_interval);
+
+    // where to save the graphs
+    string path_vertices = g_output_prefix;
+    string path_edges = g_output_prefix;
+    const bool sink = (g_output_prefix == "/dev/null" || get_output_sink() != OutputSink::FILESYSTEM);
+    if(!sink){
+        ::common::filesystem::mkdir(g_output_prefix);
+        path_vertices = g_output_prefix + "/ugg_benchmark.v";
+        path_edges = g_output_prefix + "/ugg_benchmark.e";
+    }
+
+    vector<benchmark::Result> results;
+    for(auto& graph : graphs){
+        for(int num_threads : g_benchmark_threads){
+            g_num_vertices = graph.first;
+            g_num_edges = graph.second;
+            g_num_threads = num_threads;
 
-    vector<Edge> edges;
+            benchmark::Result best;
+            for(int repetition = 0; repetition < g_benchmark_repetitions; repetition++){
+                cout << "\n[benchmark] vertices: " << g_num_vertices << ", edges: " << g_num_edges << ", threads: " << g_num_threads
+                     << ", repetition: " << (repetition +1) << "/" << g_benchmark_repetitions << endl;
+                const size_t first_phase = report::phases().size();
+                GraphFiles files = generate_graph(path_vertices, path_edges);
+                if(!sink){ // do not fill the scratch directory
+                    ::unlink(path_vertices.c_str());
+                    ::unlink(path_edges.c_str());
+                }
+                for(auto& shard : files.m_edge_shards){ // whatever the sink, but never /dev/null itself
+                    if(shard.m_path != "/dev/null"){ ::unlink(shard.m_path.c_str()); }
+                }
+
+                benchmark::Result result;
+                result.m_num_vertices = g_num_vertices;
+                result.m_num_edges = g_num_edges;
+                result.m_num_threads = g_num_threads;
+                for(size_t i = first_phase; i < report::phases().size(); i++){
+                    const report::PhaseStatistics& phase = report::phases()[i];
+                    if(phase.m_name == "Generate edges"){
+                        result.m_generate_time += phase.m_wall_time;
+                    } else if(phase.m_name == "Sort edges" || phase.m_name == "Symmetrize edges"){
+                        result.m_sort_time += phase.m_wall_time;
+                    } else if(phase.m_name == "Generate vertices"){
+                        result.m_vertices_time += phase.m_wall_time;
+                    } else {
+                        result.m_write_time += phase.m_wall_time;
+                    }
+                    result.m_bytes_written += phase.m_bytes_written;
+                }
+                if(repetition == 0 || result.total_time() < best.total_time()){ best = result; }
+            }
+            results.push_back(best);
+        }
+    }
+
+    progress::set_phase("Done");
+    progress::stop();
+
+    benchmark::compute_scaling(results);
+    cout << "\n";
+    benchmark::print(cout, results);
+    cout << "\n";
+}
+
+static edge_list_t make_edges(bool* out_sorted, DedupStatistics* out_statistics){
+    DedupBackend backend = g_dedup_backend;
+    if(backend == DedupBackend::AUTO){ backend = make_plan(g_num_vertices, g_num_edges, g_num_threads, g_memory_budget, DedupBackend::AUTO, g_directed).m_backend; }
+    cout << "Dedup backend: " << to_string(backend) << endl;
+    report::set_parameter("dedup", to_string(backend));
+
+    switch(backend){
+    case DedupBackend::BITMAP:
+        *out_sorted = true; // the bitmap is scanned in order
+        return make_edges_bitmap(g_num_vertices, g_num_edges, g_seed, g_num_threads, g_directed);
+    case DedupBackend::LOCKFREE:
+        *out_sorted = false;
+        return make_edges_lockfree(g_num_vertices, g_num_edges, g_seed, g_num_threads, out_statistics, g_directed);
+    case DedupBackend::CUCKOO: {
+        *out_sorted = false;
+        CuckooStatistics stats;
+        edge_list_t edges = make_edges_cuckoo(g_num_vertices, g_num_edges, g_seed, g_num_threads, &stats, g_directed);
+        cout << "Cuckoo map, capacity reserved: " << stats.m_capacity_reserved << ", final capacity: " << stats.m_capacity_final << ", expansions: " << stats.m_num_expansions << endl;
+        cout << "Cuckoo map, time outside the expansions: " << stats.m_insert_seconds << " secs, in the expansions: " << stats.m_expansion_seconds << " secs (summed over all threads)" << endl;
+        report::set_statistic("cuckoo_insert_seconds", stats.m_insert_seconds);
+        report::set_statistic("cuckoo_expansion_seconds", stats.m_expansion_seconds);
+        out_statistics->m_num_rehashes = stats.m_num_expansions;
+        return edges;
+    }
+    case DedupBackend::SHARDED:
+        *out_sorted = true; // the shards are sorted and concatenated in order
+        return make_edges_sharded(g_num_vertices, g_num_edges, g_seed, g_num_threads, g_dedup_num_shards > 0 ? g_dedup_num_shards : g_num_threads, g_dedup_batch_size, out_statistics, g_directed);
+    case DedupBackend::SAMPLING:
+        *out_sorted = true; // the ranges are generated in order
+        if(g_num_parts > 0){
+            return make_edges_sampling(g_num_vertices, g_num_edges, g_seed, g_num_threads, g_part_first_source, g_part_last_source, g_directed);
+        } else {
+            return make_edges_sampling(g_num_vertices, g_num_edges, g_seed, g_num_threads, 0, g_num_vertices, g_directed);
+        }
+    default:
+        *out_sorted = false;
+        return make_edges_hashset(out_statistics);
+    }
+}
+
+static edge_list_t make_edges_hashset(DedupStatistics* out_statistics){
+    unordered_set<Edge> edges_created;
+    uint64_t num_rehashes = 0;
+    generate_edges(g_num_vertices, g_num_edges, g_seed, /* single thread */ 1, [&edges_created, &num_rehashes](int, const Edge& edge){
+        size_t bucket_count = edges_created.bucket_count();
+        bool inserted = edges_created.insert(edge).second;
+        num_rehashes += (edges_created.bucket_count() != bucket_count);
+        return inserted;
+    }, g_directed);
+
+    // with separate chaining, the probe length of the k-th edge in a bucket is k
+    out_statistics->m_num_rehashes = num_rehashes;
+    for(size_t i = 0; i < edges_created.bucket_count(); i++){
+        uint64_t bucket_size = edges_created.bucket_size(i);
+        out_statistics->m_num_probes += bucket_size * (bucket_size +1) / 2;
+        out_statistics->m_num_keys += bucket_size;
+        out_statistics->m_max_probe_length = max(out_statistics->m_max_probe_length, bucket_size);
+    }
+
+    edge_list_t edges;
     edges.reserve(edges_created.size());
     for(auto& it_edge : edges_created){
         edges.push_back(it_edge);
@@ -170,68 +479,136 @@ static vector<Edge> make_edges(){
 
     return edges;
 }
-#endif
 
-static vector<uint64_t> make_vertices(){
-    vector<uint64_t> vertices;
-    vertices.reserve(g_num_vertices);
-    vertices.push_back(1); // the first vertex is always 1
-    uint64_t vertex_id = 1;
-    while(vertices.size() < g_num_vertices){
-        if(vertex_id >= g_exp_factor_vertex_id * vertices.size()){
-            vertices.push_back(vertex_id +1 /* because we started from 1 */);
-        }
-        vertex_id++;
+// The candidates are counted by the progress counters, while the edges accepted are those actually returned: any
+// edge accepted by the dedup in excess of the requested quantity, and then discarded, is reported as trimmed
+static void print_generation_statistics(const DedupStatistics& dedup_statistics, uint64_t num_edges){
+    progress::Totals totals = progress::totals();
+    uint64_t num_candidates = totals.m_edges_accepted + totals.m_self_loops + totals.m_duplicates;
+    uint64_t num_trimmed = totals.m_edges_accepted > num_edges ? totals.m_edges_accepted - num_edges : 0;
+    auto percentage = [num_candidates](uint64_t value){ return num_candidates > 0 ? 100.0 * value / num_candidates : 0.0; };
+    cout << "Candidate edges drawn: " << num_candidates << ", accepted: " << num_edges << " (" << percentage(num_edges) << "%), "
+            "trimmed: " << num_trimmed << " (" << percentage(num_trimmed) << "%), "
+            "self loops: " << totals.m_self_loops << " (" << percentage(totals.m_self_loops) << "%), "
+            "duplicates: " << totals.m_duplicates << " (" << percentage(totals.m_duplicates) << "%)\n";
+    cout << "Dedup table, probe length avg: ";
+    if(dedup_statistics.m_num_keys > 0){
+        cout << dedup_statistics.avg_probe_length() << ", max: " << dedup_statistics.m_max_probe_length;
+    } else {
+        cout << "n/a, max: n/a";
     }
+    cout << ", rehashes: " << dedup_statistics.m_num_rehashes << endl;
 
-    return vertices;
+    report::set_statistic("candidates", num_candidates);
+    report::set_statistic("edges_accepted", num_edges);
+    report::set_statistic("edges_trimmed", num_trimmed);
+    report::set_statistic("self_loops", totals.m_self_loops);
+    report::set_statistic("duplicates", totals.m_duplicates);
+    report::set_statistic("avg_probe_length", dedup_statistics.avg_probe_length());
+    report::set_statistic("max_probe_length", dedup_statistics.m_max_probe_length);
+    report::set_statistic("rehashes", dedup_statistics.m_num_rehashes);
 }
 
-static void save_vertices(const vector<uint64_t>& vertices){
-    fstream out { g_output_prefix + ".v" , ios::out };
-    if(!out.good()) ERROR("Cannot create the file `" << g_output_prefix << ".v" << "'");
-    for(auto v: vertices){
-        out << v << "\n";
+// The edges accepted so far by the worker threads of each NUMA node, as counted by the progress counters. Empty if
+// NUMA awareness is not enabled, or with a single thread, not pinned.
+static vector<size_t> edges_accepted_per_node(){
+    vector<size_t> result;
+    if(!numa::is_enabled() || g_num_threads <= 1) return result;
+    result.assign(numa::num_nodes(), 0);
+    for(int t = 0; t < g_num_threads; t++){
+        result[numa::node_of_thread(t, g_num_threads)] += progress::counters(t).m_edges_accepted.load(memory_order_relaxed);
     }
-    out.close();
+    return result;
 }
 
-static void save_edges(const vector<uint64_t>& vertices, const vector<Edge>& edges){
-    fstream out { g_output_prefix + ".e" , ios::out };
-    if(!out.good()) ERROR("Cannot create the file `" << g_output_prefix << ".e" << "'");
-    for(auto e: edges){
-        assert(e.m_source < vertices.size());
-        assert(e.m_destination < vertices.size());
-        out << vertices[e.m_source] << " " << vertices[e.m_destination] << "\n";
-    }
-    out.close();
-}
-
-static void save_properties(){
-    fstream out { g_output_prefix + ".properties" , ios::out };
-    if(!out.good()) ERROR("Cannot create the file `" << g_output_prefix << ".properties" << "'");
+static uint64_t save_properties(const GraphFiles& files){
+    const vector<EdgeShard>& edge_shards = files.m_edge_shards;
+    stringstream out;
     out << "# Generated by the Uniform Graph Generator (UGG), on " << get_current_datetime() << "\n\n";
 
-    string basedir = common::filesystem::directory(g_output_prefix);
-    string basename = g_output_prefix;
-    if(basedir != "."){
-        basename = g_output_prefix.substr(basedir.length());
-        if(basename[0] == '/') basename = basename.substr(1);
-    }
+    string basename = get_basename(g_output_prefix);
 
     out << "# Filenames of graph on local filesystem\n";
-    out << "graph." << basename << ".vertex-file = " << basename << ".v" << "\n";
-    out << "graph." << basename << ".edge-file = " << basename << ".e" << "\n\n";
+    if(g_num_parts > 0){
+        out << "\n# The graph is split in " << g_num_parts << " parts, each generated with --part i/" << g_num_parts << " and covering a disjoint range of sources.\n";
+        out << "# Concatenating the vertex files and the edge files of all parts, in order, yields the whole graph.\n";
+        out << "graph." << basename << ".parts = " << g_num_parts << "\n";
+        vector<uint64_t> boundaries = split_sources(g_num_vertices, g_num_parts, g_directed);
+        for(uint64_t i = 0; i < g_num_parts; i++){
+            string part_basename = get_basename(get_part_prefix(i));
+            out << "graph." << basename << ".part." << i << ".vertex-file = " << part_basename << ".v" << "\n";
+            out << "graph." << basename << ".part." << i << ".vertices = " << boundaries[i +1] - boundaries[i] << "\n";
+            out << "graph." << basename << ".part." << i << ".edge-file = " << part_basename << ".e" << "\n";
+            out << "graph." << basename << ".part." << i << ".edges = " << count_edges_sampling(g_num_vertices, g_num_edges, g_seed, boundaries[i], boundaries[i +1], g_directed) << "\n";
+        }
+        out << "\n";
+    } else if(g_partition_rows > 0){
+        out << "graph." << basename << ".vertex-file = " << basename << ".v" << "\n";
+        GridPartitioning grid = make_grid_partitioning(g_num_vertices, g_partition_rows, g_partition_columns, g_symmetric || g_directed);
+        vector<uint64_t> vertices = make_vertices(g_num_vertices, g_exp_factor_vertex_id);
+        uint64_t max_edges = 0;
+        for(auto& block : edge_shards){ max_edges = max(max_edges, block.m_num_edges); }
+        out << "\n# The edges are partitioned in a grid of " << grid.num_rows() << " x " << grid.num_columns() << " blocks, in row major order.\n";
+        out << "# The row i covers the sources in [row-first-vertex[i], row-first-vertex[i +1]), the column j the destinations\n";
+        out << "# in [column-first-vertex[j], column-first-vertex[j +1]), with the vertex IDs of the vertex file. Each file is sorted.\n";
+        const uint64_t num_edges = g_symmetric ? 2 * g_num_edges : g_num_edges;
+        out << "# Balance, max / avg edges per block: " << (num_edges > 0 ? static_cast<double>(max_edges) * edge_shards.size() / num_edges : 1.0) << "\n";
+        out << "graph." << basename << ".edge-partitioning = " << (grid.num_columns() == 1 ? "1d:" + to_string(grid.num_rows()) : "2d:" + to_string(grid.num_rows()) + "x" + to_string(grid.num_columns())) << "\n";
+        auto print_first_vertices = [&](const char* name, const vector<uint64_t>& boundaries){
+            out << "graph." << basename << "." << name << " = ";
+            for(size_t i = 0; i +1 < boundaries.size(); i++){ out << (i > 0 ? ", " : "") << vertices[boundaries[i]]; }
+            out << "\n";
+        };
+        print_first_vertices("edge-partition.row-first-vertex", grid.m_rows);
+        print_first_vertices("edge-partition.column-first-vertex", grid.m_columns);
+        out << "graph." << basename << ".edge-partitions = " << edge_shards.size() << "\n";
+        for(size_t i = 0; i < edge_shards.size(); i++){
+            char checksum[16];
+            snprintf(checksum, sizeof(checksum), "%08x", edge_shards[i].m_checksum);
+            string suffix = edge_shards[i].m_path.substr(g_output_prefix.length() + 2 /* .e */);
+            out << "graph." << basename << ".edge-partition." << i << ".file = " << basename << ".e" << suffix << "\n";
+            out << "graph." << basename << ".edge-partition." << i << ".edges = " << edge_shards[i].m_num_edges << "\n";
+            out << "graph." << basename << ".edge-partition." << i << ".crc32 = " << checksum << "\n";
+        }
+        out << "\n";
+    } else if(edge_shards.empty()){
+        out << "graph." << basename << ".vertex-file = " << basename << ".v" << "\n";
+        out << "graph." << basename << ".edge-file = " << basename << ".e" << "\n\n";
+    } else {
+        out << "graph." << basename << ".vertex-file = " << basename << ".v" << "\n";
+        out << "\n# The edges are split in " << edge_shards.size() << " files, each sorted and covering a disjoint range of sources\n";
+        out << "graph." << basename << ".edge-shards = " << edge_shards.size() << "\n";
+        for(size_t i = 0; i < edge_shards.size(); i++){
+            string suffix = edge_shards[i].m_path.substr(g_output_prefix.length() + 2 /* .e */);
+            out << "graph." << basename << ".edge-shard." << i << ".file = " << basename << ".e" << suffix << "\n";
+            out << "graph." << basename << ".edge-shard." << i << ".edges = " << edge_shards[i].m_num_edges << "\n";
+        }
+        out << "\n";
+    }
 
     out << "# Graph metadata for reporting purposes\n";
     out << "graph." << basename << ".meta.vertices = " << g_num_vertices << "\n";
-    out << "graph." << basename << ".meta.edges = " << g_num_edges << "\n\n";
+    out << "graph." << basename << ".meta.edges = " << (g_symmetric ? 2 * g_num_edges : g_num_edges) << "\n\n";
 
     out << "# Properties describing the graph format\n";
-    out << "graph." << basename << ".directed = false\n\n";
+    if(g_symmetric){
+        out << "# Each undirected edge is saved in both directions, (u, v) and (v, u), as a directed graph\n";
+        out << "graph." << basename << ".directed = true\n\n";
+    } else if(g_directed){
+        out << "graph." << basename << ".directed = true\n\n";
+    } else {
+        out << "graph." << basename << ".directed = false\n\n";
+    }
+
+    const EdgeWeights& weights = get_edge_weights();
+    if(weights.is_weighted()){
+        out << "# The weight of each edge, " << weights.to_string() << ", is the third column of the edge file\n";
+        out << "graph." << basename << ".edge-properties.names = weight\n";
+        out << "graph." << basename << ".edge-properties.types = " << (weights.is_integer() ? "int" : "real") << "\n\n";
+    }
 
     out << "# List of supported algorithms on the graph\n";
-    out << "graph." << basename << ".algorithms = bfs, cdlp, lcc, pr, wcc\n\n";
+    out << "graph." << basename << ".algorithms = bfs, cdlp, lcc, pr, " << (weights.is_weighted() ? "sssp, " : "") << "wcc\n\n";
 
     out << "\n";
     out << "#\n";
@@ -250,23 +627,128 @@ static void save_properties(){
     out << "graph." << basename << ".pr.damping-factor = 0.85\n";
     out << "graph." << basename << ".pr.num-iterations = 10\n\n";
 
+    if(weights.is_weighted()){
+        out << "# Parameters for SSSP, the source is the vertex with the highest degree in the largest connected component,\n";
+        if(g_num_parts > 0 && !g_sssp_whole_graph){
+            out << "# among the edges of the part 0 only, with " << files.m_largest_component << " vertices out of " << g_num_vertices << "\n";
+        } else {
+            out << "# with " << files.m_largest_component << " vertices out of " << g_num_vertices << "\n";
+        }
+        out << "graph." << basename << ".sssp.weight-property = weight\n";
+        out << "graph." << basename << ".sssp.source-vertex = " << files.m_sssp_source << "\n\n";
+    }
+
     out << "# No parameters for WCC\n";
 
-    out.close();
+    string content = out.str();
+    Writer writer { g_output_prefix + ".properties" };
+    writer.write(content.data(), content.size());
+    writer.close();
+    return writer.bytes_written();
+}
+
+// The manifest of a part, to validate its files before concatenating them with those of the other parts
+static uint64_t save_manifest(const string& path_prefix, const GraphFiles& files){
+    stringstream out;
+    out << "# Part " << g_part << " of " << g_num_parts << " of a graph generated by the Uniform Graph Generator (UGG), on " << get_current_datetime() << "\n";
+    out << "# Concatenating the vertex files and the edge files of all parts, in order, yields the whole graph\n\n";
+
+    string basename = get_basename(g_output_prefix);
+    char checksum[16];
+
+    out << "# The whole graph\n";
+    out << "graph." << basename << ".meta.vertices = " << g_num_vertices << "\n";
+    out << "graph." << basename << ".meta.edges = " << g_num_edges << "\n";
+    out << "graph." << basename << ".meta.seed = " << g_seed << "\n";
+    out << "graph." << basename << ".meta.max-vertex-id = " << (uint64_t) ceil(g_exp_factor_vertex_id * (g_num_vertices -1)) +1 << "\n";
+    out << "graph." << basename << ".meta.max-vertex-id-factor = " << g_exp_factor_vertex_id << "\n";
+    out << "graph." << basename << ".meta.weights = " << get_edge_weights().to_string() << "\n";
+    out << "graph." << basename << ".directed = " << ((g_symmetric || g_directed) ? "true" : "false") << "\n";
+    out << "graph." << basename << ".parts = " << g_num_parts << "\n\n";
+
+    out << "# This part, the sources are positions in the sorted list of vertices, [first-source, last-source)\n";
+    out << "graph." << basename << ".part = " << g_part << "\n";
+    out << "graph." << basename << ".part.first-source = " << g_part_first_source << "\n";
+    out << "graph." << basename << ".part.last-source = " << g_part_last_source << "\n";
+    out << "graph." << basename << ".part.vertex-file = " << get_basename(path_prefix) << ".v\n";
+    out << "graph." << basename << ".part.vertices = " << g_part_last_source - g_part_first_source << "\n";
+    out << "graph." << basename << ".part.vertices.bytes = " << files.m_vertices_bytes << "\n";
+    snprintf(checksum, sizeof(checksum), "%08x", files.m_vertices_checksum);
+    out << "graph." << basename << ".part.vertices.crc32 = " << checksum << "\n";
+    out << "graph." << basename << ".part.edge-file = " << get_basename(path_prefix) << ".e\n";
+    out << "graph." << basename << ".part.edges = " << files.m_num_edges << "\n";
+    out << "graph." << basename << ".part.edges.bytes = " << files.m_edges_bytes << "\n";
+    snprintf(checksum, sizeof(checksum), "%08x", files.m_edges_checksum);
+    out << "graph." << basename << ".part.edges.crc32 = " << checksum << "\n";
+
+    string content = out.str();
+    Writer writer { path_prefix + ".manifest" };
+    writer.write(content.data(), content.size());
+    writer.close();
+    return writer.bytes_written();
+}
+
+// The last component of the given path
+static string get_basename(const string& path_prefix){
+    string basedir = common::filesystem::directory(path_prefix);
+    string basename = path_prefix;
+    if(basedir != "."){
+        basename = path_prefix.substr(basedir.length());
+        if(basename[0] == '/') basename = basename.substr(1);
+    }
+    return basename;
+}
+
+// The size of the vertex file to save, with --part only the vertices in [g_part_first_source, g_part_last_source)
+static uint64_t get_vertices_file_size(){
+    if(g_num_parts == 0){ return vertices_file_size(g_num_vertices, g_exp_factor_vertex_id); }
+    // the ID of a vertex only depends on its position, the size of a prefix of the list is the size of its file
+    return vertices_file_size(g_part_last_source, g_exp_factor_vertex_id) - vertices_file_size(g_part_first_source, g_exp_factor_vertex_id);
+}
+
+// The prefix of the files of the given part, <output>.part0000, <output>.part0001, ...
+static string get_part_prefix(uint64_t part){
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".part%04" PRIu64, part);
+    return g_output_prefix + suffix;
 }
 
 static void parse_command_line_arguments(int argc, char* argv[]){
     using namespace cxxopts;
 
-    Options options(argv[0], "Uniform Graph Generator (ugg): create a uniform undirected graph");
-    options.custom_help(" -V <num_vertices> -E <num_edges> -o <output_prefix> [-m <max_vertex_id>]");
+    Options options(argv[0], "Uniform Graph Generator (ugg): create a uniform undirected or directed graph");
+    options.custom_help(" -V <num_vertices> -E <num_edges> -o <output_prefix> [-m <max_vertex_id>]\n  " + string(argv[0]) + " --benchmark -V <v1,v2,...> -E <e1,e2,...> -t <t1,t2,...> [-o <scratch_dir>]");
     options.add_options()
-       ("E, num_edges", "The total number of edges in the graph. If the value provided is less than the number of vertices, then it assumes that the given quantity is the average number of edges per vertex", value<ComputerQuantity>())
+       ("E, num_edges", "The total number of edges in the graph. If the value provided is less than the number of vertices, then it assumes that the given quantity is the average number of edges per vertex. With --benchmark, a comma separated list", value<string>())
        ("h, help", "Show this help menu")
        ("m, max_vertex_id", "The expansion factor for the maximum vertex id to assign to the vertices/nodes in the graph. Node IDs will be in the domain  [0, max_vertex_id * num_vertices)", value<double>())
-       ("o, output", "The prefix path where to save the created graph", value<string>())
-       ("V, num_vertices", "The number of vertices to generate in the graph", value<ComputerQuantity>())
+       ("o, output", "The prefix path where to save the created graph. With --benchmark, the scratch directory where to save the graphs, or /dev/null (default) to discard them", value<string>())
+       ("V, num_vertices", "The number of vertices to generate in the graph. With --benchmark, a comma separated list", value<string>())
        ("seed", "Seed to initialise the random generator", value<uint64_t>())
+       ("t, threads", "The number of threads to use to generate the edges. With --benchmark, a comma separated list", value<string>())
+       ("dedup", "The data structure to discard duplicate edges: auto, hashset, bitmap, lockfree, cuckoo, sharded or sampling (draw the edges without replacement, no dedup needed)", value<string>()->default_value("auto"))
+       ("dedup_shards", "Sharded dedup backend, the number of source ranges, each owned by a single thread. By default it is equal to the number of threads", value<uint64_t>())
+       ("dedup_batch_size", "Sharded dedup backend, the number of edges in each batch sent to the owner of a shard", value<uint64_t>()->default_value(to_string(g_dedup_batch_size)))
+       ("hugepages", "The kind of pages for the edge arrays and the dedup tables: none, thp (transparent huge pages), 2mb or 1gb (explicit huge pages, reserved in /proc/sys/vm/nr_hugepages)", value<string>()->default_value("none"))
+       ("numa", "Pin the threads to the CPUs, split evenly among the NUMA nodes, and place the data on the node of the threads operating on it. The summary and the report include the bandwidth of each node")
+       ("perf_counters", "Measure the hardware performance counters (cycles, instructions, LLC, dTLB and branch misses) in each phase of the run")
+       ("progress", "Print the progress every given number of seconds. The progress is also printed when the process receives SIGUSR1", value<double>())
+       ("trace", "Record the spans executed by each thread and save them in the given file, in the Chrome trace format (chrome://tracing, ui.perfetto.dev)", value<string>())
+       ("direct_io", "Write the output files with O_DIRECT, bypassing the page cache")
+       ("mmap", "Save the edges through a memory mapping of the file, formatted in parallel by all threads")
+       ("shards", "Split the edges in the given number of files, <output>.e.0000, <output>.e.0001, ..., each sorted and covering a disjoint range of sources, written in parallel", value<uint64_t>())
+       ("weights", "The weight of each edge, saved as a third column of the edge file: none, uniform:<min>,<max> (real, in [min, max)), exponential:<rate> (real) or integer:<min>,<max> (integer, in [min, max])", value<string>()->default_value("none"))
+       ("directed", "Generate a directed graph, drawing the edges among the V * (V -1) ordered pairs (u, v), u != v, so that (u, v) and (v, u) are distinct edges")
+       ("symmetric", "Save each edge in both directions, (u, v) and (v, u), sorted by source, as a directed graph")
+       ("partition", "Partition the edges for the distributed graph systems, one file per partition written in parallel: `1d:P' for P ranges of sources, <output>.e.1d.PPPP, or `2d:RxC' for a grid of R ranges of sources x C ranges of destinations, <output>.e.2d.RRRR.CCCC", value<string>())
+       ("part", "Generate only the part i of N of the graph, as `i/N', saved in <output>.partIIII.{v,e,manifest}. The parts cover disjoint ranges of sources and can be generated independently, on different machines, with the same seed", value<string>())
+       ("sssp_whole_graph", "With --part and --weights, the part 0 picks the source vertex of SSSP in the largest component of the whole graph, rather than of its own edges only. It generates again the edges of all other parts, one part at a time: the work of generating the whole graph, on a single machine")
+       ("output_sink", "Where to send the output files: file, null (format the content and compute the checksums, but discard the bytes) or memory (copy the bytes into main memory)", value<string>()->default_value("file"))
+       ("report", "Save the parameters and the per-phase statistics of the run in the given file, in JSON format", value<string>())
+       ("benchmark", "Run the whole pipeline for each combination of the given vertices, edges and threads, and report the strong and weak scaling efficiency")
+       ("repetitions", "With --benchmark, the number of times each combination is executed, only the fastest run is retained", value<int>()->default_value("1"))
+       ("dry_run", "Show the plan, i.e. the dedup backend selected with its estimated time and memory, and exit without generating the graph")
+       ("memory_budget", "The max amount of memory the `auto' dedup backend can use for the adjacency bitmap. By default it is 1/4 of the physical memory", value<ComputerQuantity>())
    ;
 
     auto parsed_args = options.parse(argc, argv);
@@ -276,22 +758,51 @@ static void parse_command_line_arguments(int argc, char* argv[]){
         exit(EXIT_SUCCESS);
     }
 
+    g_benchmark = parsed_args.count("benchmark") > 0;
+    g_directed = parsed_args.count("directed") > 0; // before resolving the number of edges
+
     if(parsed_args.count("num_vertices") == 0){ ERROR("Missing mandatory argument --num_vertices"); }
-    g_num_vertices = parsed_args["num_vertices"].as<ComputerQuantity>();
-    if(g_num_vertices == 0){ ERROR("No vertices to generate"); }
+    g_benchmark_vertices = parse_list<ComputerQuantity, uint64_t>(parsed_args["num_vertices"].as<string>(), "--num_vertices");
+    for(auto num_vertices : g_benchmark_vertices){
+        if(num_vertices == 0){ ERROR("No vertices to generate"); }
+    }
 
     if(parsed_args.count("num_edges") == 0){ ERROR("Missing mandatory argument --num_edges"); }
-    g_num_edges = parsed_args["num_edges"].as<ComputerQuantity>();
-    if(g_num_edges == 0){ ERROR("No edges to generate"); }
-    if(g_num_edges < g_num_vertices){
-        cout << "Assuming to create " << g_num_edges << " on average per vertex\n\n";
-        g_num_edges *= g_num_vertices /2; /* because the graph is undirected */
+    g_benchmark_edges = parse_list<ComputerQuantity, uint64_t>(parsed_args["num_edges"].as<string>(), "--num_edges");
+    for(auto num_edges : g_benchmark_edges){
+        if(num_edges == 0){ ERROR("No edges to generate"); }
+    }
+
+    if(parsed_args.count("threads") > 0){
+        g_benchmark_threads = parse_list<int>(parsed_args["threads"].as<string>(), "--threads");
+        for(auto num_threads : g_benchmark_threads){
+            if(num_threads <= 0){ ERROR("Invalid number of threads: " << num_threads); }
+        }
+    } else {
+        g_benchmark_threads.push_back(max(1, g_num_threads)); // hardware_concurrency() can return 0
     }
 
-    if(parsed_args.count("output") == 0 || parsed_args["output"].as<string>().empty()){
+    if(!g_benchmark){
+        if(g_benchmark_vertices.size() > 1){ ERROR("Multiple values for --num_vertices are only allowed with --benchmark"); }
+        if(g_benchmark_edges.size() > 1){ ERROR("Multiple values for --num_edges are only allowed with --benchmark"); }
+        if(g_benchmark_threads.size() > 1){ ERROR("Multiple values for --threads are only allowed with --benchmark"); }
+    }
+    g_num_vertices = g_benchmark_vertices[0];
+    g_num_edges = g_benchmark ? g_benchmark_edges[0] : resolve_num_edges(g_benchmark_edges[0], g_num_vertices);
+    g_num_threads = *max_element(begin(g_benchmark_threads), end(g_benchmark_threads));
+    if(!g_benchmark && g_num_edges > max_num_edges(g_num_vertices, g_directed)){
+        ERROR("Too many edges: " << g_num_edges << ", " << (g_directed ? "a directed" : "an undirected") << " graph with " << g_num_vertices << " vertices has at most " << max_num_edges(g_num_vertices, g_directed) << " edges");
+    }
+    g_benchmark_repetitions = parsed_args["repetitions"].as<int>();
+    if(g_benchmark_repetitions <= 0){ ERROR("Invalid number of repetitions: " << g_benchmark_repetitions); }
+
+    if(parsed_args.count("output") > 0 && !parsed_args["output"].as<string>().empty()){
+        g_output_prefix = parsed_args["output"].as<string>();
+    } else if(g_benchmark){
+        g_output_prefix = "/dev/null";
+    } else {
         ERROR("Missing mandatory argument --output");
     }
-    g_output_prefix = parsed_args["output"].as<string>();
 
     if(parsed_args.count("max_vertex_id") > 0){
         double exp_factor =  parsed_args["max_vertex_id"].as<double>();
@@ -304,13 +815,232 @@ static void parse_command_line_arguments(int argc, char* argv[]){
     if(parsed_args.count("seed") > 0){
         g_seed = parsed_args["seed"].as<uint64_t>();
     }
+    set_edge_weights(parse_edge_weights(parsed_args["weights"].as<string>(), g_seed, g_directed));
+
+    memory::set_huge_pages(memory::parse_huge_pages(parsed_args["hugepages"].as<string>()));
+
+    if(parsed_args.count("numa") > 0){
+        numa::enable();
+    }
+
+    string dedup = parsed_args["dedup"].as<string>();
+    if(dedup == "auto"){
+        g_dedup_backend = DedupBackend::AUTO;
+    } else if (dedup == "hashset"){
+        g_dedup_backend = DedupBackend::HASHSET;
+    } else if (dedup == "bitmap"){
+        g_dedup_backend = DedupBackend::BITMAP;
+        if(g_num_vertices > (1ull<<32)){ ERROR("Too many vertices for the bitmap dedup backend: " << g_num_vertices); }
+    } else if (dedup == "lockfree"){
+        g_dedup_backend = DedupBackend::LOCKFREE;
+        if(g_num_vertices > ConcurrentEdgeSet::MAX_NUM_VERTICES){ ERROR("Too many vertices for the lockfree dedup backend: " << g_num_vertices); }
+    } else if (dedup == "cuckoo"){
+        g_dedup_backend = DedupBackend::CUCKOO;
+        if(g_num_vertices > ConcurrentEdgeSet::MAX_NUM_VERTICES){ ERROR("Too many vertices for the cuckoo dedup backend: " << g_num_vertices); }
+    } else if (dedup == "sharded"){
+        g_dedup_backend = DedupBackend::SHARDED;
+        if(g_num_vertices > ConcurrentEdgeSet::MAX_NUM_VERTICES){ ERROR("Too many vertices for the sharded dedup backend: " << g_num_vertices); }
+    } else if (dedup == "sampling"){
+        g_dedup_backend = DedupBackend::SAMPLING;
+        if(g_num_vertices > (1ull<<32)){ ERROR("Too many vertices for the sampling backend: " << g_num_vertices); }
+    } else {
+        ERROR("Invalid value for the argument --dedup: `" << dedup << "'");
+    }
 
-    cout << "Number of vertices to create: " << g_num_vertices << "\n";
-    cout << "Number of edges to create: " << g_num_edges << "\n";
-    cout << "Max vertex id: " << (uint64_t) ceil(g_exp_factor_vertex_id * (g_num_vertices -1)) +1 << " (exp factor: " << g_exp_factor_vertex_id << ")\n";
-    cout << "Output prefix: " << g_output_prefix << "\n";
+    if(parsed_args.count("dedup_shards") > 0){
+        g_dedup_num_shards = parsed_args["dedup_shards"].as<uint64_t>();
+        if(g_dedup_num_shards == 0){ ERROR("Invalid number of shards: 0"); }
+    }
+    g_dedup_batch_size = parsed_args["dedup_batch_size"].as<uint64_t>();
+    if(g_dedup_batch_size == 0){ ERROR("Invalid batch size: 0"); }
+
+    if(parsed_args.count("perf_counters") > 0){
+        perf::enable();
+    }
+
+    set_output_sink(parse_output_sink(parsed_args["output_sink"].as<string>()));
+    set_direct_io(parsed_args.count("direct_io") > 0);
+    g_mmap_output = parsed_args.count("mmap") > 0;
+    if(g_mmap_output && is_direct_io()){ ERROR("The options --mmap and --direct_io are mutually exclusive"); }
+    if(g_mmap_output && get_output_sink() != OutputSink::FILESYSTEM){ ERROR("The option --mmap requires --output_sink file"); }
+    if(parsed_args.count("shards") > 0){
+        g_num_output_shards = parsed_args["shards"].as<uint64_t>();
+        if(g_num_output_shards == 0){ ERROR("Invalid number of shards for the argument --shards: 0"); }
+        if(g_mmap_output){ ERROR("The options --mmap and --shards are mutually exclusive"); }
+    }
+
+    g_symmetric = parsed_args.count("symmetric") > 0;
+    if(g_symmetric && g_directed){ ERROR("The options --symmetric and --directed are mutually exclusive"); }
+
+    if(parsed_args.count("partition") > 0){ // 1d:P or 2d:RxC
+        string partition = parsed_args["partition"].as<string>();
+        if(partition.compare(0, 3, "1d:") == 0){
+            g_partition_rows = parse_list<uint64_t>(partition.substr(3), "--partition")[0];
+            g_partition_columns = 1;
+        } else if(partition.compare(0, 3, "2d:") == 0 && partition.find('x', 3) != string::npos){
+            size_t separator = partition.find('x', 3);
+            g_partition_rows = parse_list<uint64_t>(partition.substr(3, separator - 3), "--partition")[0];
+            g_partition_columns = parse_list<uint64_t>(partition.substr(separator +1), "--partition")[0];
+        } else {
+            ERROR("Invalid value for the argument --partition: `" << partition << "', expected 1d:P or 2d:RxC");
+        }
+        if(g_partition_rows == 0 || g_partition_columns == 0){ ERROR("Invalid value for the argument --partition: `" << partition << "', no partitions"); }
+        if(g_num_vertices > (1ull<<32)){ ERROR("Too many vertices for the argument --partition: " << g_num_vertices); }
+        if(g_num_output_shards > 0){ ERROR("The options --partition and --shards are mutually exclusive"); }
+        if(g_mmap_output){ ERROR("The options --partition and --mmap are mutually exclusive"); }
+    }
+
+    if(parsed_args.count("part") > 0){ // i/N
+        string part = parsed_args["part"].as<string>();
+        size_t slash = part.find('/');
+        if(slash == string::npos){ ERROR("Invalid value for the argument --part: `" << part << "', expected i/N"); }
+        g_part = parse_list<uint64_t>(part.substr(0, slash), "--part")[0];
+        g_num_parts = parse_list<uint64_t>(part.substr(slash +1), "--part")[0];
+        if(g_num_parts == 0 || g_part >= g_num_parts){ ERROR("Invalid value for the argument --part: `" << part << "', expected 0 <= i < N"); }
+        if(g_benchmark){ ERROR("The options --part and --benchmark are mutually exclusive"); }
+        if(g_num_output_shards > 0){ ERROR("The options --part and --shards are mutually exclusive"); }
+        if(g_partition_rows > 0){ ERROR("The options --part and --partition are mutually exclusive"); }
+        if(g_symmetric){ ERROR("The options --part and --symmetric are mutually exclusive, the reverse edges of a part are generated by the other parts"); }
+        if(g_num_parts > g_num_vertices){ ERROR("Too many parts: " << g_num_parts << ", the graph has only " << g_num_vertices << " vertices"); }
+        if(g_dedup_backend != DedupBackend::AUTO && g_dedup_backend != DedupBackend::SAMPLING){ ERROR("The option --part requires --dedup sampling"); }
+        if(g_num_vertices > (1ull<<32)){ ERROR("Too many vertices for the sampling backend: " << g_num_vertices); }
+        g_dedup_backend = DedupBackend::SAMPLING; // the only backend that can generate a part alone
+
+        vector<uint64_t> boundaries = split_sources(g_num_vertices, g_num_parts, g_directed);
+        g_part_first_source = boundaries[g_part];
+        g_part_last_source = boundaries[g_part +1];
+        g_part_num_edges = count_edges_sampling(g_num_vertices, g_num_edges, g_seed, g_part_first_source, g_part_last_source, g_directed);
+    }
+    if(parsed_args.count("sssp_whole_graph") > 0){
+        if(g_num_parts == 0){ ERROR("The option --sssp_whole_graph requires --part"); }
+        g_sssp_whole_graph = true;
+    }
+
+    if(parsed_args.count("progress") > 0){
+        g_progress_interval = parsed_args["progress"].as<double>();
+        if(g_progress_interval < 0){ ERROR("Invalid interval for the argument --progress: " << g_progress_interval); }
+    }
+
+    if(parsed_args.count("trace") > 0){
+        g_trace_path = parsed_args["trace"].as<string>();
+        if(g_trace_path.empty()){ ERROR("Invalid path for the argument --trace"); }
+        trace::enable();
+    }
+
+    if(parsed_args.count("report") > 0){
+        g_report_path = parsed_args["report"].as<string>();
+        if(g_report_path.empty()){ ERROR("Invalid path for the argument --report"); }
+    }
+
+    g_dry_run = parsed_args.count("dry_run") > 0;
+
+    if(parsed_args.count("memory_budget") > 0){
+        g_memory_budget = parsed_args["memory_budget"].as<ComputerQuantity>();
+    } else {
+        g_memory_budget = static_cast<uint64_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE) / 4;
+    }
+
+    if(g_benchmark){
+        cout << "Benchmark, vertices: " << parsed_args["num_vertices"].as<string>() << ", edges: " << parsed_args["num_edges"].as<string>()
+             << ", threads: " << (parsed_args.count("threads") > 0 ? parsed_args["threads"].as<string>() : to_string(g_num_threads))
+             << ", repetitions: " << g_benchmark_repetitions << "\n";
+        cout << "Exp factor for the vertex ids: " << g_exp_factor_vertex_id << "\n";
+        cout << "Scratch directory: " << g_output_prefix << "\n";
+    } else {
+        cout << "Number of vertices to create: " << g_num_vertices << "\n";
+        cout << "Number of edges to create: " << g_num_edges << "\n";
+        cout << "Max vertex id: " << (uint64_t) ceil(g_exp_factor_vertex_id * (g_num_vertices -1)) +1 << " (exp factor: " << g_exp_factor_vertex_id << ")\n";
+        cout << "Output prefix: " << g_output_prefix << "\n";
+        if(g_num_parts > 0){
+            cout << "Part: " << g_part << "/" << g_num_parts << ", sources [" << g_part_first_source << ", " << g_part_last_source << "), edges: " << g_part_num_edges
+                 << ", files: " << get_part_prefix(g_part) << ".{v,e,manifest}\n";
+        }
+        cout << "Size of the output files: " << get_vertices_file_size() << " bytes (vertices), about "
+             << estimate_edges_file_size(g_num_vertices, g_num_parts > 0 ? g_part_num_edges : g_num_edges, g_exp_factor_vertex_id) * (g_symmetric ? 2 : 1) << " bytes (edges)\n";
+        if(g_symmetric){ cout << "Symmetric: each edge is saved in both directions, " << 2 * g_num_edges << " lines in total\n"; }
+        if(g_directed){ cout << "Directed: the edges (u, v) and (v, u) are distinct\n"; }
+        if(get_edge_weights().is_weighted()){ cout << "Edge weights: " << get_edge_weights().to_string() << "\n"; }
+    }
+    if(get_output_sink() != OutputSink::FILESYSTEM){
+        cout << "Output sink: " << to_string(get_output_sink()) << ", no files are written\n";
+    } else if(is_direct_io()){
+        cout << "Direct I/O: the output files are written with O_DIRECT\n";
+    } else if(g_mmap_output){
+        cout << "Memory mapped output: the edges are formatted in parallel directly in the file\n";
+    }
     cout << "Seed for the random generator:  " << g_seed << "\n";
+    if(!g_benchmark){
+        cout << "Number of threads: " << g_num_threads << "\n";
+    }
+    cout << "Huge pages: " << memory::to_string(memory::get_huge_pages()) << "\n";
+    if(numa::is_enabled()){
+        cout << "NUMA awareness: " << numa::num_nodes() << " node(s), " << numa::num_cpus() << " CPU(s)\n";
+    }
+    cout << "Dedup backend: " << to_string(g_dedup_backend) << "\n";
+    if(g_dedup_backend == DedupBackend::SHARDED){
+        cout << "Dedup shards: " << (g_dedup_num_shards > 0 ? to_string(g_dedup_num_shards) : string("one per thread")) << ", batch size: " << g_dedup_batch_size << "\n";
+    }
+    if(!g_benchmark){
+        print_plan(cout, make_plan(g_num_vertices, g_num_parts > 0 ? g_part_num_edges : g_num_edges, g_num_threads, g_memory_budget, g_dedup_backend, g_directed));
+    } else if(g_dry_run){ // the plan of each run of the benchmark
+        for(uint64_t num_vertices : g_benchmark_vertices){
+            for(uint64_t num_edges : g_benchmark_edges){
+                num_edges = resolve_num_edges(num_edges, num_vertices);
+                if(num_edges > max_num_edges(num_vertices, g_directed)) continue; // too dense, skipped by the benchmark
+                for(int num_threads : g_benchmark_threads){
+                    cout << "\n[benchmark] vertices: " << num_vertices << ", edges: " << num_edges << ", threads: " << num_threads << "\n";
+                    print_plan(cout, make_plan(num_vertices, num_edges, num_threads, g_memory_budget, g_dedup_backend, g_directed));
+                }
+            }
+        }
+    }
     cout << endl;
+
+    report::set_parameter("num_vertices", g_num_vertices);
+    report::set_parameter("num_edges", g_num_edges);
+    report::set_parameter("max_vertex_id_factor", g_exp_factor_vertex_id);
+    report::set_parameter("output_prefix", g_output_prefix);
+    report::set_parameter("seed", g_seed);
+    report::set_parameter("num_threads", g_num_threads);
+    report::set_parameter("hugepages", memory::to_string(memory::get_huge_pages()));
+    report::set_parameter("numa", numa::is_enabled());
+    report::set_parameter("perf_counters", perf::is_enabled());
+    report::set_parameter("output_sink", to_string(get_output_sink()));
+    report::set_parameter("direct_io", is_direct_io());
+    report::set_parameter("mmap", g_mmap_output);
+    report::set_parameter("shards", g_num_output_shards);
+    report::set_parameter("symmetric", g_symmetric);
+    report::set_parameter("directed", g_directed);
+    report::set_parameter("weights", get_edge_weights().to_string());
+    report::set_parameter("partition", g_partition_rows == 0 ? string("none") : g_partition_columns == 1 ? "1d:" + to_string(g_partition_rows) : "2d:" + to_string(g_partition_rows) + "x" + to_string(g_partition_columns));
+    report::set_parameter("part", g_part);
+    report::set_parameter("parts", g_num_parts);
+    report::set_parameter("sssp_whole_graph", g_sssp_whole_graph);
+    report::set_parameter("dedup", to_string(g_dedup_backend));
+    report::set_parameter("benchmark", g_benchmark);
+    report::set_parameter("date", get_current_datetime());
+}
+
+// If the number of edges is less than the number of vertices, it is the average number of edges per vertex
+static uint64_t resolve_num_edges(uint64_t num_edges, uint64_t num_vertices){
+    if(num_edges < num_vertices){
+        cout << "Assuming to create " << num_edges << " on average per vertex\n\n";
+        num_edges *= g_directed ? num_vertices : num_vertices /2; /* an undirected edge counts for both its vertices */
+    }
+    return num_edges;
+}
+
+template<typename T, typename R>
+static vector<R> parse_list(const string& list, const char* option){
+    vector<R> result;
+    for(auto& token : benchmark::split(list)){
+        istringstream in { token };
+        T value;
+        if(!(in >> value)){ ERROR("Invalid value for the argument " << option << ": `" << token << "'"); }
+        result.push_back(value);
+    }
+    if(result.empty()){ ERROR("Missing value for the argument " << option); }
+    return result;
 }
 
 static string get_current_datetime(){
@@ -0,0 +1,517 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+#include "lib/common/error.hpp"
+#include "lib/common/quantity.hpp"
+#include "lib/cxxopts.hpp"
+#include "lib/cuckoohash.hpp"
+#include "benchmark.hpp"
+#include "bitmap.hpp"
+#include "concurrent_set.hpp"
+#include "cuckoo_dedup.hpp"
+#include "edge.hpp"
+#include "generator.hpp"
+#include "memory.hpp"
+#include "output.hpp"
+#include "planner.hpp"
+#include "sampling.hpp"
+#include "sharded.hpp"
+#include "sort.hpp"
+#include "weights.hpp"
+
+using namespace common;
+using namespace std;
+
+// globals
+vector<uint64_t> g_num_vertices; // sweep over the number of vertices in the graph
+vector<uint64_t> g_num_edges; // sweep over the number of edges, or candidate edges, in each run
+int g_max_threads; // max number of threads to test
+uint64_t g_seed = 42; // seed for the random generator
+int g_num_repetitions = 1; // number of times each run is repeated
+vector<string> g_benchmarks; // the benchmarks to execute
+string g_output_dir; // where the writers save their files
+uint64_t g_memory_budget; // max amount of memory for the adjacency bitmap
+bool g_directed = false; // whether the dedup backends generate directed graphs
+
+// function prototypes
+static void parse_command_line_arguments(int argc, char* argv[]);
+static vector<uint64_t> parse_quantities(const string& list);
+static bool is_enabled(const string& benchmark);
+static vector<int> get_thread_counts();
+static void print_result(const char* benchmark, const char* variant, uint64_t num_vertices, uint64_t num_edges, int num_threads, int repetition, uint64_t num_items, uint64_t num_bytes, double seconds);
+template<typename Function> static double measure(Function&& fn);
+static void bench_rng(uint64_t num_vertices, uint64_t num_edges);
+static void bench_candidates(uint64_t num_vertices, uint64_t num_edges);
+static void bench_dedup(uint64_t num_vertices, uint64_t num_edges);
+static void check_uniformity(uint64_t num_vertices, uint64_t num_edges);
+static void bench_insert(uint64_t num_vertices, uint64_t num_edges);
+static void bench_sort(uint64_t num_vertices, uint64_t num_edges);
+static void bench_vertices(uint64_t num_vertices);
+static void bench_writers(uint64_t num_vertices, uint64_t num_edges);
+
+// entry point
+int main(int argc, char* argv[]) {
+    try {
+        parse_command_line_arguments(argc, argv);
+
+        cout << "# huge pages: " << memory::to_string(memory::get_huge_pages()) << ", seed: " << g_seed << "\n";
+        cout << "benchmark,variant,vertices,edges,density,threads,repetition,items,bytes,seconds,items_per_second" << endl;
+        for(uint64_t num_vertices : g_num_vertices){
+            if(is_enabled("vertices")){ bench_vertices(num_vertices); }
+
+            for(uint64_t num_edges : g_num_edges){
+                // the generator slows down sharply as the graph gets close to complete
+                if(num_edges > max_num_edges(num_vertices, g_directed) / 2){
+                    cout << "# skipping V=" << num_vertices << ", E=" << num_edges << ": too dense" << endl;
+                    continue;
+                }
+
+                if(is_enabled("rng")){ bench_rng(num_vertices, num_edges); }
+                if(is_enabled("candidates")){ bench_candidates(num_vertices, num_edges); }
+                if(is_enabled("dedup")){ bench_dedup(num_vertices, num_edges); }
+                if(is_enabled("uniformity")){ check_uniformity(num_vertices, num_edges); }
+                if(is_enabled("insert")){ bench_insert(num_vertices, num_edges); }
+                if(is_enabled("sort")){ bench_sort(num_vertices, num_edges); }
+                if(is_enabled("writers")){ bench_writers(num_vertices, num_edges); }
+            }
+        }
+
+    } catch (common::Error& e){
+        cerr << e << endl;
+        cerr << "Type `" << argv[0] << " --help' to check how to run the program\n";
+        cerr << "Program terminated" << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+static bool is_enabled(const string& benchmark){
+    for(auto& b : g_benchmarks){
+        if(b == benchmark || b == "all") return true;
+    }
+    return false;
+}
+
+// 1, 2, 4, ..., up to g_max_threads
+static vector<int> get_thread_counts(){
+    vector<int> result;
+    for(int num_threads = 1; num_threads <= g_max_threads; num_threads *= 2){ result.push_back(num_threads); }
+    return result;
+}
+
+static void print_result(const char* benchmark, const char* variant, uint64_t num_vertices, uint64_t num_edges, int num_threads, int repetition, uint64_t num_items, uint64_t num_bytes, double seconds){
+    double density = (num_vertices > 1) ? static_cast<double>(num_edges) / max_num_edges(num_vertices, g_directed) : 0;
+    cout << benchmark << "," << variant << "," << num_vertices << "," << num_edges << "," << density << "," << num_threads << "," << repetition << ","
+         << num_items << "," << num_bytes << "," << seconds << "," << (uint64_t) (seconds > 0 ? num_items / seconds : 0) << endl;
+}
+
+template<typename Function>
+static double measure(Function&& fn){
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    auto t1 = chrono::steady_clock::now();
+    return chrono::duration<double>(t1 - t0).count();
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Random number generator                                                  *
+ *                                                                           *
+ *****************************************************************************/
+
+// Draw `num_edges' random numbers, split among the threads, either raw or mapped to a vertex
+static void bench_rng(uint64_t num_vertices, uint64_t num_edges){
+    for(int num_threads : get_thread_counts()){
+        for(int r = 0; r < g_num_repetitions; r++){
+            atomic<uint64_t> sink = 0; // prevent the compiler from discarding the draws
+            double seconds = measure([&](){
+                run_in_parallel(num_threads, [&](int thread_id){
+                    std::mt19937_64 random_generator { g_seed + thread_id };
+                    uint64_t count = num_edges * (thread_id +1) / num_threads - num_edges * thread_id / num_threads;
+                    uint64_t accumulator = 0;
+                    for(uint64_t i = 0; i < count; i++){ accumulator ^= random_generator(); }
+                    sink ^= accumulator;
+                });
+            });
+            print_result("rng", "mt19937_64", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+
+            seconds = measure([&](){
+                run_in_parallel(num_threads, [&](int thread_id){
+                    std::mt19937_64 random_generator { g_seed + thread_id };
+                    uniform_int_distribution<uint64_t> uniform_distribution {0, num_vertices -1}; // [a, b]
+                    uint64_t count = num_edges * (thread_id +1) / num_threads - num_edges * thread_id / num_threads;
+                    uint64_t accumulator = 0;
+                    for(uint64_t i = 0; i < count; i++){ accumulator ^= uniform_distribution(random_generator); }
+                    sink ^= accumulator;
+                });
+            });
+            print_result("rng", "uniform_int_distribution", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+        }
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Candidate edges                                                          *
+ *                                                                           *
+ *****************************************************************************/
+
+// The loop of the generator, accepting every candidate that is not a self loop
+static void bench_candidates(uint64_t num_vertices, uint64_t num_edges){
+    for(int num_threads : get_thread_counts()){
+        for(int r = 0; r < g_num_repetitions; r++){
+            vector<uint64_t> sink(num_threads * 8, 0); // one cache line per thread
+            double seconds = measure([&](){
+                generate_edges(num_vertices, num_edges, g_seed, num_threads, [&sink](int thread_id, const Edge& edge){
+                    sink[thread_id * 8] ^= edge.m_source ^ edge.m_destination;
+                    return true;
+                });
+            });
+            print_result("candidates", "generate_edges", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+        }
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Dedup backends                                                           *
+ *                                                                           *
+ *****************************************************************************/
+
+// Generate the whole list of edges with each dedup backend, as `ugg --dedup <backend> [--directed]'
+static void bench_dedup(uint64_t num_vertices, uint64_t num_edges){
+    const bool bitmap_fits = num_vertices <= (1ull<<32) && AdjacencyBitmap::memory_footprint(num_vertices, g_directed) <= g_memory_budget;
+    const bool packed_edges = num_vertices <= ConcurrentEdgeSet::MAX_NUM_VERTICES;
+
+    for(int num_threads : get_thread_counts()){
+        for(int r = 0; r < g_num_repetitions; r++){
+            if(num_threads == 1){ // as ugg, the hash set is always single threaded
+                double seconds = measure([&](){
+                    unordered_set<Edge> edges_created;
+                    generate_edges(num_vertices, num_edges, g_seed, 1, [&edges_created](int, const Edge& edge){
+                        return edges_created.insert(edge).second;
+                    }, g_directed);
+                });
+                print_result("dedup", "hashset", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+            }
+            if(bitmap_fits){
+                double seconds = measure([&](){ make_edges_bitmap(num_vertices, num_edges, g_seed, num_threads, g_directed); });
+                print_result("dedup", "bitmap", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+            }
+            if(packed_edges){
+                double seconds = measure([&](){ make_edges_lockfree(num_vertices, num_edges, g_seed, num_threads, nullptr, g_directed); });
+                print_result("dedup", "lockfree", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+                seconds = measure([&](){ make_edges_cuckoo(num_vertices, num_edges, g_seed, num_threads, nullptr, g_directed); });
+                print_result("dedup", "cuckoo", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+                seconds = measure([&](){ make_edges_sharded(num_vertices, num_edges, g_seed, num_threads, num_threads, /* batch size */ 256, nullptr, g_directed); });
+                print_result("dedup", "sharded", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+            }
+            if(num_vertices <= (1ull<<32)){
+                double seconds = measure([&](){ make_edges_sampling(num_vertices, num_edges, g_seed, num_threads, 0, num_vertices, g_directed); });
+                print_result("dedup", "sampling", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+            }
+        }
+    }
+}
+
+// Check that the edges of a backend are spread uniformly: the number of edges in each of the 4 source ranges
+// with the same number of possible edges must be within 5 standard deviations of the binomial mean. Sampling
+// without replacement is even tighter than the binomial, so the bound is conservative.
+static void check_uniformity(const char* variant, uint64_t num_vertices, uint64_t num_edges, int num_threads, const edge_list_t& edges){
+    constexpr uint64_t num_ranges = 4;
+    const vector<uint64_t> boundaries = split_sources(num_vertices, num_ranges, g_directed);
+    const double num_possible_edges = count_edges_before(num_vertices, num_vertices, g_directed);
+    vector<uint64_t> counts(num_ranges, 0);
+    for(const Edge& edge : edges){ counts[find_source_part(boundaries, edge.m_source)]++; }
+
+    double max_deviation = 0; // in standard deviations
+    stringstream ss;
+    for(uint64_t i = 0; i < num_ranges; i++){
+        double p = (count_edges_before(boundaries[i +1], num_vertices, g_directed) - count_edges_before(boundaries[i], num_vertices, g_directed)) / num_possible_edges;
+        double mean = num_edges * p;
+        double stddev = sqrt(num_edges * p * (1 - p));
+        if(stddev > 0){ max_deviation = max(max_deviation, abs(counts[i] - mean) / stddev); }
+        ss << (i > 0 ? ", " : "") << counts[i];
+    }
+    cout << "# uniformity " << variant << ", V=" << num_vertices << ", E=" << num_edges << ", threads=" << num_threads << ", edges per source range: [" << ss.str() << "], max deviation: " << max_deviation << " sigma" << endl;
+    if(edges.size() != num_edges){ ERROR("Backend " << variant << " created " << edges.size() << " edges rather than " << num_edges); }
+    if(max_deviation > 5){ ERROR("Backend " << variant << " is not uniform, max deviation: " << max_deviation << " sigma"); }
+}
+
+static void check_uniformity(uint64_t num_vertices, uint64_t num_edges){
+    const bool bitmap_fits = num_vertices <= (1ull<<32) && AdjacencyBitmap::memory_footprint(num_vertices, g_directed) <= g_memory_budget;
+    const bool packed_edges = num_vertices <= ConcurrentEdgeSet::MAX_NUM_VERTICES;
+
+    for(int num_threads : get_thread_counts()){
+        if(bitmap_fits){
+            check_uniformity("bitmap", num_vertices, num_edges, num_threads, make_edges_bitmap(num_vertices, num_edges, g_seed, num_threads, g_directed));
+        }
+        if(packed_edges){
+            check_uniformity("lockfree", num_vertices, num_edges, num_threads, make_edges_lockfree(num_vertices, num_edges, g_seed, num_threads, nullptr, g_directed));
+            check_uniformity("cuckoo", num_vertices, num_edges, num_threads, make_edges_cuckoo(num_vertices, num_edges, g_seed, num_threads, nullptr, g_directed));
+            check_uniformity("sharded", num_vertices, num_edges, num_threads, make_edges_sharded(num_vertices, num_edges, g_seed, num_threads, num_threads, /* batch size */ 256, nullptr, g_directed));
+            check_uniformity("sharded_4", num_vertices, num_edges, num_threads, make_edges_sharded(num_vertices, num_edges, g_seed, num_threads, /* shards */ 4, /* batch size */ 256, nullptr, g_directed));
+        }
+        if(num_vertices <= (1ull<<32)){
+            check_uniformity("sampling", num_vertices, num_edges, num_threads, make_edges_sampling(num_vertices, num_edges, g_seed, num_threads, 0, num_vertices, g_directed));
+        }
+    }
+}
+
+// Draw the candidate edges upfront, so that the benchmark only measures the inserts
+static vector<Edge> make_candidates(uint64_t num_vertices, uint64_t num_edges){
+    vector<Edge> candidates;
+    candidates.reserve(num_edges);
+    std::mt19937_64 random_generator { g_seed };
+    uniform_int_distribution<uint64_t> uniform_distribution {0, num_vertices -1}; // [a, b]
+    while(candidates.size() < num_edges){
+        Edge edge { uniform_distribution(random_generator), uniform_distribution(random_generator) };
+        if(edge.m_source == edge.m_destination) continue; // try again
+        candidates.push_back(edge);
+    }
+    return candidates;
+}
+
+template<typename Insert>
+static void run_insert(const char* name, uint64_t num_vertices, const vector<Edge>& candidates, int num_threads, int repetition, Insert&& insert){
+    double seconds = measure([&](){
+        run_in_parallel(num_threads, [&](int thread_id){
+            uint64_t start = candidates.size() * thread_id / num_threads;
+            uint64_t end = candidates.size() * (thread_id +1) / num_threads;
+            for(uint64_t i = start; i < end; i++){
+                insert(candidates[i]);
+            }
+        });
+    });
+    print_result("insert", name, num_vertices, candidates.size(), num_threads, repetition, candidates.size(), 0, seconds);
+}
+
+// Insert a fixed sequence of candidates in the concurrent hash tables, without drawing them
+static void bench_insert(uint64_t num_vertices, uint64_t num_edges){
+    if(num_vertices > ConcurrentEdgeSet::MAX_NUM_VERTICES) return;
+    vector<Edge> candidates = make_candidates(num_vertices, num_edges);
+
+    for(int num_threads : get_thread_counts()){
+        for(int r = 0; r < g_num_repetitions; r++){
+            { // baseline, the same configuration of the original parallel generator
+                cuckoohash_map<Edge, bool> edges_created;
+                run_insert("cuckoo", num_vertices, candidates, num_threads, r, [&](const Edge& edge){ return edges_created.insert(edge, true); });
+            }
+            { // the configuration of the cuckoo dedup backend
+                CuckooEdgeSet edges_created;
+                edges_created.reserve(num_edges + num_edges / 8);
+                run_insert("cuckoo_reserved", num_vertices, candidates, num_threads, r, [&](const Edge& edge){ return edges_created.insert(pack_edge(edge)); });
+            }
+            {
+                ConcurrentEdgeSet edges_created { num_edges };
+                run_insert("lockfree", num_vertices, candidates, num_threads, r, [&](const Edge& edge){ return edges_created.insert(edge); });
+            }
+        }
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Sort                                                                     *
+ *                                                                           *
+ *****************************************************************************/
+
+static void bench_sort(uint64_t num_vertices, uint64_t num_edges){
+    if(num_vertices > ConcurrentEdgeSet::MAX_NUM_VERTICES) return;
+    const edge_list_t input = make_edges_lockfree(num_vertices, num_edges, g_seed, g_max_threads); // in hash order
+
+    for(int num_threads : get_thread_counts()){
+        for(int r = 0; r < g_num_repetitions; r++){
+            edge_list_t edges = input;
+            double seconds = measure([&](){ sort_edges(edges, num_vertices, num_threads); });
+            print_result("sort", "sort_edges", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+            seconds = measure([&](){ symmetrize_edges(edges, num_vertices, num_threads); }); // input already sorted
+            print_result("sort", "symmetrize_edges", num_vertices, num_edges, num_threads, r, num_edges, 0, seconds);
+        }
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Vertices                                                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+static void bench_vertices(uint64_t num_vertices){
+    for(int r = 0; r < g_num_repetitions; r++){
+        for(double exp_factor : { 1.0, 1.9 }){
+            double seconds = measure([&](){ make_vertices(num_vertices, exp_factor); });
+            print_result("vertices", exp_factor == 1.0 ? "exp_factor_1.0" : "exp_factor_1.9", num_vertices, 0, 1, r, num_vertices, 0, seconds);
+        }
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Writers                                                                  *
+ *                                                                           *
+ *****************************************************************************/
+
+// Baseline for the text writer, save the edges as pairs of 64-bit vertex IDs, without any formatting
+static uint64_t save_edges_binary(const string& path, const vector<uint64_t>& vertices, const edge_list_t& edges){
+    FILE* file = fopen(path.c_str(), "w");
+    if(file == nullptr) ERROR("Cannot create the file `" << path << "'");
+    constexpr uint64_t BUFFER_SIZE = 1ull << 16; // in pairs
+    vector<uint64_t> buffer(2 * BUFFER_SIZE);
+    for(uint64_t i = 0; i < edges.size(); i += BUFFER_SIZE){
+        uint64_t end = min<uint64_t>(edges.size(), i + BUFFER_SIZE);
+        for(uint64_t j = i; j < end; j++){
+            buffer[2 * (j - i)] = vertices[edges[j].m_source];
+            buffer[2 * (j - i) +1] = vertices[edges[j].m_destination];
+        }
+        if(fwrite(buffer.data(), 2 * sizeof(uint64_t), end - i, file) != end - i){ fclose(file); ERROR("Cannot write the file `" << path << "'"); }
+    }
+    fclose(file);
+    return edges.size() * 2 * sizeof(uint64_t);
+}
+
+static void bench_writers(uint64_t num_vertices, uint64_t num_edges){
+    if(num_vertices > ConcurrentEdgeSet::MAX_NUM_VERTICES) return;
+    edge_list_t edges = make_edges_lockfree(num_vertices, num_edges, g_seed, g_max_threads);
+    sort_edges(edges, num_vertices, g_max_threads);
+    vector<uint64_t> vertices = make_vertices(num_vertices, 1.0);
+    const string path = g_output_dir + "/ugg_bench.tmp";
+
+    for(int r = 0; r < g_num_repetitions; r++){
+        uint64_t num_bytes = 0;
+        double seconds = measure([&](){ num_bytes = save_vertices(path, vertices); });
+        print_result("writers", "text_vertices", num_vertices, num_edges, 1, r, num_vertices, num_bytes, seconds);
+
+        seconds = measure([&](){ num_bytes = save_edges(path, vertices, edges); });
+        print_result("writers", "text_edges", num_vertices, num_edges, 1, r, num_edges, num_bytes, seconds);
+
+        set_edge_weights(EdgeWeights{ WeightDistribution::UNIFORM, 0, 1, g_seed, false });
+        seconds = measure([&](){ num_bytes = save_edges(path, vertices, edges); });
+        print_result("writers", "text_edges_weighted", num_vertices, num_edges, 1, r, num_edges, num_bytes, seconds);
+        set_edge_weights(EdgeWeights{});
+
+        set_direct_io(true);
+        seconds = measure([&](){ num_bytes = save_edges(path, vertices, edges); });
+        print_result("writers", "text_edges_direct_io", num_vertices, num_edges, 1, r, num_edges, num_bytes, seconds);
+        set_direct_io(false);
+
+        for(int num_threads : get_thread_counts()){
+            seconds = measure([&](){ num_bytes = save_edges_mmap(path, vertices, edges, num_threads); });
+            print_result("writers", "text_edges_mmap", num_vertices, num_edges, num_threads, r, num_edges, num_bytes, seconds);
+        }
+
+        seconds = measure([&](){ num_bytes = save_edges_binary(path, vertices, edges); });
+        print_result("writers", "binary_edges", num_vertices, num_edges, 1, r, num_edges, num_bytes, seconds);
+    }
+
+    unlink(path.c_str());
+}
+
+static void parse_command_line_arguments(int argc, char* argv[]){
+    using namespace cxxopts;
+
+    Options options(argv[0], "Microbenchmarks of the stages of the Uniform Graph Generator (ugg), the results are printed in CSV");
+    options.custom_help(" [-V <num_vertices,...>] [-E <num_edges,...>] [-t <max_threads>] [--benchmarks <name,...>]");
+    options.add_options()
+       ("b, benchmarks", "The benchmarks to execute: all, rng, candidates, dedup, uniformity, insert, sort, vertices, writers", value<string>()->default_value("all"))
+       ("E, num_edges", "Comma separated list of the number of edges (or candidate edges) in each run", value<string>()->default_value("16777216"))
+       ("directed", "Generate directed graphs in the dedup benchmark")
+       ("h, help", "Show this help menu")
+       ("V, num_vertices", "Comma separated list of the number of vertices in the graph", value<string>()->default_value("1048576"))
+       ("hugepages", "The kind of pages for the edge arrays and the dedup tables: none, thp, 2mb or 1gb", value<string>()->default_value("none"))
+       ("memory_budget", "Skip the adjacency bitmap if it takes more than the given amount of memory. By default it is 1/4 of the physical memory", value<ComputerQuantity>())
+       ("o, output_dir", "The directory where the writers save their (temporary) files", value<string>()->default_value("/tmp"))
+       ("r, repetitions", "The number of times each run is repeated", value<int>()->default_value("1"))
+       ("seed", "Seed to initialise the random generator", value<uint64_t>())
+       ("t, threads", "The max number of threads to test. Each run doubles the number of threads, starting from 1. By default it is the number of hardware threads", value<int>())
+   ;
+
+    auto parsed_args = options.parse(argc, argv);
+
+    if(parsed_args.count("help") > 0){
+        cout << options.help() << endl;
+        exit(EXIT_SUCCESS);
+    }
+
+    g_num_vertices = parse_quantities(parsed_args["num_vertices"].as<string>());
+    for(auto v : g_num_vertices){
+        if(v < 2){ ERROR("Too few vertices: " << v); }
+    }
+    g_num_edges = parse_quantities(parsed_args["num_edges"].as<string>());
+    for(auto e : g_num_edges){
+        if(e == 0){ ERROR("No edges to insert"); }
+    }
+
+    g_max_threads = std::thread::hardware_concurrency();
+    if(parsed_args.count("threads") > 0){
+        g_max_threads = parsed_args["threads"].as<int>();
+        if(g_max_threads <= 0){ ERROR("Invalid number of threads: " << g_max_threads); }
+    }
+    if(g_max_threads <= 0){ g_max_threads = 1; } // hardware_concurrency() can return 0
+
+    g_num_repetitions = parsed_args["repetitions"].as<int>();
+    if(g_num_repetitions <= 0){ ERROR("Invalid number of repetitions: " << g_num_repetitions); }
+
+    if(parsed_args.count("seed") > 0){
+        g_seed = parsed_args["seed"].as<uint64_t>();
+    }
+    g_directed = parsed_args.count("directed") > 0;
+
+    g_benchmarks = benchmark::split(parsed_args["benchmarks"].as<string>());
+    for(auto& b : g_benchmarks){
+        if(b != "all" && b != "rng" && b != "candidates" && b != "dedup" && b != "uniformity" && b != "insert" && b != "sort" && b != "vertices" && b != "writers"){
+            ERROR("Invalid benchmark: `" << b << "'");
+        }
+    }
+
+    g_output_dir = parsed_args["output_dir"].as<string>();
+
+    if(parsed_args.count("memory_budget") > 0){
+        g_memory_budget = parsed_args["memory_budget"].as<ComputerQuantity>();
+    } else {
+        g_memory_budget = static_cast<uint64_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE) / 4;
+    }
+
+    memory::set_huge_pages(memory::parse_huge_pages(parsed_args["hugepages"].as<string>()));
+}
+
+static vector<uint64_t> parse_quantities(const string& list){
+    vector<uint64_t> result;
+    for(auto& token : benchmark::split(list)){
+        istringstream in { token };
+        ComputerQuantity quantity;
+        if(!(in >> quantity)){ ERROR("Invalid quantity: `" << token << "'"); }
+        result.push_back(quantity);
+    }
+    if(result.empty()){ ERROR("Empty list: `" << list << "'"); }
+    return result;
+}
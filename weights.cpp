@@ -0,0 +1,113 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "weights.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+#include "lib/common/error.hpp"
+
+using namespace std;
+
+EdgeWeights::EdgeWeights(WeightDistribution distribution, double param1, double param2, uint64_t seed, bool directed) :
+    m_distribution(distribution), m_key(hash_mix(seed ^ 0x5851f42d4c957f2dull) /* not the stream of the edges */), m_directed(directed) {
+    switch(distribution){
+    case WeightDistribution::NONE:
+        break;
+    case WeightDistribution::UNIFORM:
+        if(!(param1 >= 0 && param1 < param2 && isfinite(param2))){ ERROR("Invalid uniform weights: [" << param1 << ", " << param2 << "), expected 0 <= min < max"); }
+        m_min = param1; m_max = param2;
+        break;
+    case WeightDistribution::EXPONENTIAL:
+        if(!(param1 > 0 && isfinite(param1))){ ERROR("Invalid exponential weights, rate: " << param1 << ", expected rate > 0"); }
+        m_rate = param1;
+        break;
+    case WeightDistribution::INTEGER:
+        // the weights must be exact as doubles
+        if(!(param1 >= 0 && param1 <= param2 && param2 < 0x1.0p53 && param1 == floor(param1) && param2 == floor(param2))){
+            ERROR("Invalid integer weights: [" << param1 << ", " << param2 << "], expected integers 0 <= min <= max < 2^53");
+        }
+        m_min = param1; m_max = param2;
+        break;
+    }
+}
+
+void EdgeWeights::weights(const Edge* edges, uint64_t count, double* out) const noexcept {
+    switch(m_distribution){
+    case WeightDistribution::UNIFORM: {
+        const double scale = m_max - m_min;
+        for(uint64_t i = 0; i < count; i++){ out[i] = m_min + scale * to_unit(random_bits(edges[i])); }
+    } break;
+    case WeightDistribution::EXPONENTIAL: {
+        const double mean = 1.0 / m_rate;
+        for(uint64_t i = 0; i < count; i++){ out[i] = -log1p(-to_unit(random_bits(edges[i]))) * mean; }
+    } break;
+    case WeightDistribution::INTEGER: {
+        const uint64_t range = static_cast<uint64_t>(m_max - m_min) +1;
+        for(uint64_t i = 0; i < count; i++){ out[i] = m_min + static_cast<double>(((unsigned __int128) random_bits(edges[i]) * range) >> 64); }
+    } break;
+    default:
+        for(uint64_t i = 0; i < count; i++){ out[i] = 0; }
+    }
+}
+
+static string format_double(double value){
+    char buffer[EdgeWeights::MAX_CHARS];
+    return string(buffer, to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+
+string EdgeWeights::to_string() const {
+    switch(m_distribution){
+    case WeightDistribution::UNIFORM: return "uniform:" + format_double(m_min) + "," + format_double(m_max);
+    case WeightDistribution::EXPONENTIAL: return "exponential:" + format_double(m_rate);
+    case WeightDistribution::INTEGER: return "integer:" + format_double(m_min) + "," + format_double(m_max);
+    default: return "none";
+    }
+}
+
+// Parse a comma separated list of exactly `count' numbers
+static void parse_parameters(const string& list, int count, double* out, const string& value){
+    const char* position = list.c_str();
+    for(int i = 0; i < count; i++){
+        char* end = nullptr;
+        out[i] = strtod(position, &end);
+        if(end == position || *end != (i +1 < count ? ',' : '\0')){ ERROR("Invalid value for the argument --weights: `" << value << "'"); }
+        position = end +1;
+    }
+}
+
+EdgeWeights parse_edge_weights(const string& value, uint64_t seed, bool directed){
+    if(value == "none") return EdgeWeights{};
+    size_t colon = value.find(':');
+    string name = value.substr(0, colon);
+    string parameters = (colon == string::npos) ? "" : value.substr(colon +1);
+    double params[2] = { 0, 0 };
+    if(name == "uniform"){
+        parse_parameters(parameters, 2, params, value);
+        return EdgeWeights{ WeightDistribution::UNIFORM, params[0], params[1], seed, directed };
+    } else if(name == "exponential"){
+        parse_parameters(parameters, 1, params, value);
+        return EdgeWeights{ WeightDistribution::EXPONENTIAL, params[0], 0, seed, directed };
+    } else if(name == "integer"){
+        parse_parameters(parameters, 2, params, value);
+        return EdgeWeights{ WeightDistribution::INTEGER, params[0], params[1], seed, directed };
+    } else {
+        ERROR("Invalid value for the argument --weights: `" << value << "'. Valid values are: none, uniform:<min>,<max>, exponential:<rate> and integer:<min>,<max>");
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: hello[at]whatsthecraic.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "edge.hpp"
+
+// The distribution of the edge weights
+enum class WeightDistribution {
+    NONE, // unweighted graph
+    UNIFORM, // real weights, uniform in [min, max)
+    EXPONENTIAL, // real weights, exponential with the given rate
+    INTEGER, // integer weights, uniform in [min, max]
+};
+
+/**
+ * The weights of the edges, drawn from a counter-based random stream: the weight of an edge is a function of the
+ * seed and of the edge alone, a keyed hash of its endpoints, rather than the next value of a sequential generator.
+ * Therefore the weights can be computed while the edges are written, without storing them in a second array, and
+ * they do not depend on the order of the edges, the number of threads, the shards or the parts. In an undirected
+ * graph, the two directions (u, v) and (v, u) of an edge, as saved by --symmetric, have the same weight.
+ */
+class EdgeWeights {
+    WeightDistribution m_distribution = WeightDistribution::NONE;
+    double m_min = 0; // uniform & integer, the min weight
+    double m_max = 0; // uniform & integer, the max weight, excluded for uniform and included for integer
+    double m_rate = 0; // exponential, the rate lambda, the mean is 1 / lambda
+    uint64_t m_key = 0; // the key of the stream, derived from the seed
+    bool m_directed = false; // whether (u, v) and (v, u) are distinct edges
+
+    // The random bits of the given edge
+    uint64_t random_bits(const Edge& edge) const noexcept {
+        uint64_t source = edge.m_source, destination = edge.m_destination;
+        if(!m_directed && source > destination){ std::swap(source, destination); }
+        return hash_mix(hash_mix(m_key ^ source) ^ destination);
+    }
+
+    // A real number in [0, 1) from the 53 most significant bits
+    static double to_unit(uint64_t bits) noexcept { return (bits >> 11) * 0x1.0p-53; }
+
+public:
+    // The max length of a weight formatted with std::to_chars, in the shortest representation
+    static constexpr uint64_t MAX_CHARS = 24;
+
+    // Unweighted graph
+    EdgeWeights() = default;
+
+    // Weights with the given distribution. For UNIFORM and INTEGER, the two parameters are the min and the max
+    // weight, for EXPONENTIAL the first parameter is the rate and the second is ignored.
+    EdgeWeights(WeightDistribution distribution, double param1, double param2, uint64_t seed, bool directed);
+
+    // Whether the edges have a weight
+    bool is_weighted() const noexcept { return m_distribution != WeightDistribution::NONE; }
+
+    // Whether the weights are integers
+    bool is_integer() const noexcept { return m_distribution == WeightDistribution::INTEGER; }
+
+    // The distribution of the weights
+    WeightDistribution distribution() const noexcept { return m_distribution; }
+
+    // The weights of `count' consecutive edges, in a loop for each distribution, that the compiler can vectorise
+    void weights(const Edge* edges, uint64_t count, double* out) const noexcept;
+
+    // String representation, as accepted by #parse_edge_weights
+    std::string to_string() const;
+};
+
+// Parse the value of the argument --weights: none, uniform:<min>,<max>, exponential:<rate> or integer:<min>,<max>
+EdgeWeights parse_edge_weights(const std::string& value, uint64_t seed, bool directed);